@@ -0,0 +1,175 @@
+/****************************************************************************
+ Author: Luma (stubma@gmail.com)
+ 
+ https://github.com/stubma/cocos2dx-common
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ ****************************************************************************/
+#ifndef __CCAABBSet_h__
+#define __CCAABBSet_h__
+
+#include "cocos2d.h"
+#include "ccMoreTypes.h"
+#include <vector>
+
+using namespace std;
+
+NS_CC_BEGIN
+
+/**
+ * A set of boxes for testing many segments at once. Boxes are kept in structure
+ * of arrays layout and tested four at a time with SSE2 or NEON, test is same as
+ * \c CCUtils::testSegmentAABB. Optionally, a uniform grid can be built from boxes,
+ * then a segment only tests boxes in cells it passes.
+ *
+ * \par
+ * Usage:
+ * <pre>
+ * CCAABBSet set;
+ * set.setBoxes(colliders, colliderCount);
+ * set.buildGrid();
+ * set.queryFirstHits(starts, ends, bulletCount, hitBoxes);
+ * </pre>
+ *
+ * \note
+ * Grid is not updated automatically, rebuild it after boxes are changed. Query
+ * reuses internal buffers so a set can't be queried in two threads at same time
+ */
+class CC_DLL CCAABBSet {
+public:
+	/// a segment and box pair which intersects
+	struct Hit {
+		/// segment index
+		int segment;
+		
+		/// box index
+		int box;
+	};
+	
+private:
+	/// box centers and half extents, padded to multiple of 4
+	vector<float> m_cx;
+	vector<float> m_cy;
+	vector<float> m_ex;
+	vector<float> m_ey;
+	
+	/// original boxes
+	vector<ccAABB> m_boxes;
+	
+	/// grid is built
+	bool m_hasGrid;
+	
+	/// grid origin
+	float m_gridX;
+	float m_gridY;
+	
+	/// cell size
+	float m_cellSize;
+	
+	/// cell count in x and y
+	int m_cols;
+	int m_rows;
+	
+	/// start of every cell in m_cellBoxes, it has cell count plus one elements
+	vector<int> m_cellStart;
+	
+	/// box indices of all cells
+	vector<int> m_cellBoxes;
+	
+	/// stamp of box, to avoid testing a box twice in one query
+	vector<unsigned int> m_stamps;
+	
+	/// current stamp
+	unsigned int m_stamp;
+	
+	/// candidate boxes of current segment
+	vector<int> m_candidates;
+	
+private:
+	/// sync structure of arrays from boxes
+	void updateArrays();
+	
+	/// collect candidate boxes of a segment from grid, returns false if segment misses grid
+	bool collectCandidates(const CCPoint& p0, const CCPoint& p1);
+	
+	/// test a segment against all boxes or candidates, call back with box index
+	template<typename T> void testSegment(const CCPoint& p0, const CCPoint& p1, T& visitor);
+	
+public:
+	CCAABBSet();
+	
+	/// remove all boxes and grid
+	void clear();
+	
+	/// replace all boxes, grid is cleared
+	void setBoxes(const ccAABB* boxes, size_t count);
+	
+	/// add a box, grid is cleared
+	void addBox(const ccAABB& box);
+	
+	/// box count
+	size_t getBoxCount() const { return m_boxes.size(); }
+	
+	/// get box by index
+	const ccAABB& getBoxAt(size_t index) const { return m_boxes[index]; }
+	
+	/**
+	 * build a uniform grid for current boxes. Box which spans many cells is put in
+	 * every cell it overlaps
+	 *
+	 * @param cellSize cell size, if it is zero or negative, twice of average box size is used
+	 */
+	void buildGrid(float cellSize = 0);
+	
+	/// remove grid, then queries test all boxes
+	void clearGrid();
+	
+	/// has grid
+	bool hasGrid() const { return m_hasGrid; }
+	
+	/**
+	 * test many segments against all boxes and get all intersected pairs. Pairs are
+	 * appended in order of segment, and box index is ascending for same segment
+	 *
+	 * @param p0 start points of segments
+	 * @param p1 end points of segments
+	 * @param count segment count
+	 * @param hits vector to append hit pairs
+	 * @return count of appended pairs
+	 */
+	size_t querySegments(const CCPoint* p0, const CCPoint* p1, size_t count, vector<Hit>& hits);
+	
+	/**
+	 * test many segments against all boxes and get first hit of every segment, which
+	 * is the box entered first when walking from start point to end point
+	 *
+	 * @param p0 start points of segments
+	 * @param p1 end points of segments
+	 * @param count segment count
+	 * @param boxes return index of first hit box for every segment, or -1 if no hit
+	 * @param fractions if not NULL, return where first hit box is entered, from 0 at start
+	 * 		point to 1 at end point. For no hit segment, it is 1
+	 * @return count of segments which hit any box
+	 */
+	size_t queryFirstHits(const CCPoint* p0, const CCPoint* p1, size_t count, int* boxes, float* fractions = NULL);
+};
+
+NS_CC_END
+
+#endif // __CCAABBSet_h__
@@ -28,14 +28,51 @@
 
 NS_CC_BEGIN
 
-/// calendar c++ wrapper
+/**
+ * calendar c++ wrapper. Time is stored as milliseconds since 1970-1-1 UTC, and it
+ * is broken down to local date fields once when time is set, so getters are plain
+ * field reads and cheap enough to be called every frame.
+ *
+ * \note
+ * Timezone offset is got from platform and cached for a 15 minutes window of UTC time,
+ * daylight saving transitions always happen at those boundaries. If system timezone is
+ * changed, call \c invalidateTimeZone.
+ */
 class CC_DLL CCCalendar : public CCObject {
 private:
     /// singleton
     static CCCalendar* s_instance;
     
-    /// time, in seconds
-    float m_time;
+    /// broken-down local time
+    struct Fields {
+        int year;
+        int month;
+        int day;
+        int weekday;
+        int hour;
+        int minute;
+        int second;
+        int millisecond;
+    };
+    
+    /// time, in milliseconds
+    int64_t m_time;
+    
+    /// local fields of current time
+    Fields m_fields;
+    
+    /// cached timezone offset, in seconds
+    int m_offset;
+    
+    /// 15 minutes window of cached offset, or -1 if no offset is cached
+    int64_t m_offsetWindow;
+    
+private:
+    /// get local timezone offset of a UTC time, in seconds
+    int getOffset(int64_t seconds);
+    
+    /// update fields from time
+    void updateFields();
     
 protected:
     CCCalendar();
@@ -44,35 +81,50 @@ public:
     virtual ~CCCalendar();
     static CCCalendar* sharedCalendar();
     
-    /// get time, since 1970-1-1
-    float getTime() { return m_time; }
+    /// get time in seconds, since 1970-1-1
+    double getTime() { return m_time / 1000.0; }
+    
+    /// set time in seconds, since 1970-1-1
+    void setTime(double time);
+    
+    /// get time in milliseconds, since 1970-1-1
+    int64_t getTimeMillis() { return m_time; }
     
-    /// set time
-    void setTime(float time) { m_time = time; }
+    /// set time in milliseconds, since 1970-1-1
+    void setTimeMillis(int64_t time);
     
     /// set time of now
     void setNow();
     
+    /// discard cached timezone offset and recompute fields of current time
+    void invalidateTimeZone();
+    
+    /// get local timezone offset of current time, in seconds
+    int getTimeZoneOffset() { return m_offset; }
+    
     /// get year
-    int getYear();
+    int getYear() { return m_fields.year; }
     
     // get month, 1 for January
-    int getMonth();
+    int getMonth() { return m_fields.month; }
     
     // get day, 1 for first day
-    int getDay();
+    int getDay() { return m_fields.day; }
     
     // get day of week, 1 for sunday
-    int getWeekday();
+    int getWeekday() { return m_fields.weekday; }
     
     // get hour
-    int getHour();
+    int getHour() { return m_fields.hour; }
     
     // get minute
-    int getMinute();
+    int getMinute() { return m_fields.minute; }
     
     // get second
-    int getSecond();
+    int getSecond() { return m_fields.second; }
+    
+    /// get millisecond
+    int getMillisecond() { return m_fields.millisecond; }
 };
 
 NS_CC_END
@@ -0,0 +1,121 @@
+/****************************************************************************
+ Author: Luma (stubma@gmail.com)
+ 
+ https://github.com/stubma/cocos2dx-common
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ ****************************************************************************/
+#ifndef __CCClock_h__
+#define __CCClock_h__
+
+#include "cocos2d.h"
+
+NS_CC_BEGIN
+
+/**
+ * Monotonic high resolution clock. Unlike \c CCUtils::currentTimeMillis, which is wall
+ * clock and may jump when user changes system time, time returned by this clock only goes
+ * forward and is in nanosecond. The origin is undefined, so it can only be used to measure
+ * interval.
+ *
+ * \par
+ * It also keeps a frame time snapshot, which is taken once at the beginning of every frame
+ * so that all animations updated in one frame see same time. To enable it, call \c attach
+ * once after director is initialized, or call \c beginFrame by yourself if you drive frames
+ * manually. If frame snapshot is never taken, frame time falls back to live time.
+ *
+ * \par
+ * For deterministic replay or test, time can be overridden by \c setOverrideTime, then live
+ * time and frame time all returns overridden value until \c clearOverrideTime is called.
+ */
+class CC_DLL CCClock {
+private:
+	/// frame time snapshot, in nanosecond
+	static int64_t s_frameTime;
+	
+	/// interval between last two frames, in nanosecond
+	static int64_t s_frameDelta;
+	
+	/// true if frame snapshot is ever taken
+	static bool s_hasFrame;
+	
+	/// overridden time, in nanosecond
+	static int64_t s_overrideTime;
+	
+	/// true if time is overridden
+	static bool s_overridden;
+	
+	/// read platform monotonic clock
+	static int64_t systemNanoTime();
+	
+public:
+	/// monotonic time in nanosecond, or overridden time
+	static int64_t nanoTime();
+	
+	/// monotonic time in millisecond, or overridden time
+	static int64_t uptimeMillis() { return nanoTime() / 1000000LL; }
+	
+	/**
+	 * schedule an update in director scheduler, with system priority so it runs
+	 * before other updates. Action manager is scheduled again after it, so actions
+	 * see snapshot of current frame. Every update takes a frame time snapshot. It is
+	 * safe to call it more than once. Must be called in gl thread, and not in a
+	 * scheduled update because scheduler doesn't reorder a target during update.
+	 */
+	static void attach();
+	
+	/// unschedule frame update scheduled by \c attach
+	static void detach();
+	
+	/// take frame time snapshot, called at the beginning of a frame
+	static void beginFrame();
+	
+	/**
+	 * frame time snapshot in nanosecond, it should be used in gl thread. If no snapshot
+	 * is taken, returns live time
+	 */
+	static int64_t getFrameTime();
+	
+	/// frame time snapshot in millisecond
+	static int64_t getFrameTimeMillis() { return getFrameTime() / 1000000LL; }
+	
+	/// interval between last two frame snapshots in nanosecond, zero if less than two snapshots
+	static int64_t getFrameDelta() { return s_frameDelta; }
+	
+	/**
+	 * override time for deterministic replay or test. Frame snapshot is reset so
+	 * frame time is also overridden
+	 *
+	 * @param ns overridden time in nanosecond
+	 */
+	static void setOverrideTime(int64_t ns);
+	
+	/// advance overridden time, it does nothing if time is not overridden
+	static void advanceOverrideTime(int64_t ns);
+	
+	/// stop overriding time, frame snapshot is reset
+	static void clearOverrideTime();
+	
+	/// is time overridden
+	static bool isTimeOverridden() { return s_overridden; }
+};
+
+NS_CC_END
+
+#endif // __CCClock_h__
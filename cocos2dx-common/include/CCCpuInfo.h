@@ -0,0 +1,116 @@
+/****************************************************************************
+ Author: Luma (stubma@gmail.com)
+ 
+ https://github.com/stubma/cocos2dx-common
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ ****************************************************************************/
+#ifndef __CCCpuInfo_h__
+#define __CCCpuInfo_h__
+
+#include "cocos2d.h"
+#include <vector>
+
+using namespace std;
+
+NS_CC_BEGIN
+
+/**
+ * CPU topology and capability, used to size worker pools and pick SIMD kernels.
+ * Information is queried once at first call and cached, then all methods are
+ * cheap and thread safe.
+ *
+ * \par
+ * Cores are grouped to clusters by max frequency, clusters are sorted from fastest
+ * to slowest. So on a big.LITTLE device, first cluster is big cores and last one
+ * is little cores. On platform which doesn't expose frequency, there is only one
+ * cluster.
+ */
+class CC_DLL CCCpuInfo {
+public:
+	/// SIMD feature flags
+	enum Feature {
+		SSE2 = 1 << 0,
+		SSE3 = 1 << 1,
+		SSSE3 = 1 << 2,
+		SSE41 = 1 << 3,
+		SSE42 = 1 << 4,
+		AVX = 1 << 5,
+		AVX2 = 1 << 6,
+		NEON = 1 << 7
+	};
+	
+	/// a group of cores with same max frequency
+	struct Cluster {
+		/// logical core count
+		int coreCount;
+		
+		/// max frequency in Hz, zero if unknown
+		int64_t maxFreq;
+		
+		/// bit mask of logical core index, up to 64 cores, zero if unknown
+		uint64_t cpuMask;
+	};
+	
+	typedef vector<Cluster> ClusterList;
+	
+private:
+	/// query and fill all information
+	static void load();
+	
+public:
+	/// logical core count, at least 1
+	static int getLogicalCoreCount();
+	
+	/// physical core count, it is less than logical count if there is hyper threading
+	static int getPhysicalCoreCount();
+	
+	/// clusters, from fastest to slowest
+	static const ClusterList& getClusters();
+	
+	/// logical core count of all clusters except slowest one, or all cores if only one cluster
+	static int getPerformanceCoreCount();
+	
+	/**
+	 * suggested count of worker thread for parallel job. It is performance core count
+	 * minus one reserved for gl thread, so little cores are not oversubscribed
+	 *
+	 * @return worker count, at least 1
+	 */
+	static int getRecommendedWorkerCount();
+	
+	/// max frequency of fastest cluster in Hz, zero if unknown
+	static int64_t getMaxFrequency();
+	
+	/// cache line size in bytes
+	static int getCacheLineSize();
+	
+	/// L2 cache size of fastest core in bytes, zero if unknown
+	static int getL2CacheSize();
+	
+	/// bit mask of \c Feature
+	static int getFeatures();
+	
+	/// check a SIMD feature
+	static bool hasFeature(Feature f) { return (getFeatures() & f) != 0; }
+};
+
+NS_CC_END
+
+#endif // __CCCpuInfo_h__
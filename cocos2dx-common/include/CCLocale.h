@@ -25,29 +25,74 @@
 #define __CCLocale__
 
 #include "cocos2d.h"
+#include "CCLocaleListener.h"
 
 using namespace std;
 
 NS_CC_BEGIN
 
-/// a locale util in C++ wrapper
+/**
+ * a locale util in C++ wrapper. Language and country are read from platform
+ * once and cached, so querying them is cheap. Platform layer must call
+ * \c notifyConfigurationChanged when system locale is changed, then cached
+ * values are refreshed and listeners are notified if they are different.
+ *
+ * \note
+ * On iOS and Mac, it observes NSCurrentLocaleDidChangeNotification so no extra
+ * work is needed. On Android, call \c SystemUtils.nativeOnLocaleChanged in GL
+ * thread from \c onConfigurationChanged of activity, for example by queueEvent
+ * of GL surface view. On Linux, language is parsed from LC_ALL, LC_MESSAGES or
+ * LANG environment variable.
+ */
 class CC_DLL CCLocale : public CCObject {
 private:
     // singleton
     static CCLocale* s_instance;
     
+    typedef vector<CCLocaleListener*> ListenerList;
+    
+private:
+    /// read language and country from platform
+    void load();
+    
 protected:
     CCLocale();
     
+    /// cached language iso code
+    string m_language;
+    
+    /// cached country iso code
+    string m_country;
+    
+    /// listeners, not retained
+    ListenerList m_listeners;
+    
 public:
     virtual ~CCLocale();
     static CCLocale* sharedLocale();
     
     /// get language iso code
-    string getLanguage();
+    const string& getLanguage() { return m_language; }
     
     /// get country iso code
-    string getCountry();
+    const string& getCountry() { return m_country; }
+    
+    /**
+     * read locale from platform again, and notify listeners if language or
+     * country is changed. It must be called in GL thread.
+     */
+    void notifyConfigurationChanged();
+    
+    /**
+     * add a locale listener, listener is not retained so it must be removed
+     * before it is destroyed. Adding same listener twice takes no effect.
+     *
+     * @param l listener
+     */
+    void addListener(CCLocaleListener* l);
+    
+    /// remove a locale listener
+    void removeListener(CCLocaleListener* l);
 };
 
 NS_CC_END
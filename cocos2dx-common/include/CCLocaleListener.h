@@ -0,0 +1,51 @@
+/****************************************************************************
+ Author: Luma (stubma@gmail.com)
+ 
+ https://github.com/stubma/cocos2dx-common
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ ****************************************************************************/
+#ifndef __CCLocaleListener_h__
+#define __CCLocaleListener_h__
+
+#include "cocos2d.h"
+
+using namespace std;
+
+NS_CC_BEGIN
+
+/**
+ * listener to get notified when system locale is changed, a pure virtual
+ * class act as an interface
+ */
+class CC_DLL CCLocaleListener {
+public:
+	/**
+	 * notified when language or country of system locale is changed. It is
+	 * called after new values are cached so \c CCLocale already returns them.
+	 *
+	 * @param language new language iso code
+	 * @param country new country iso code
+	 */
+	virtual void onLocaleChanged(const string& language, const string& country) = 0;
+};
+
+NS_CC_END
+
+#endif // __CCLocaleListener_h__
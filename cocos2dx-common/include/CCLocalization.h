@@ -25,27 +25,302 @@
 #define __CCLocalization_h__
 
 #include "cocos2d.h"
+#include "CCStringTable.h"
+#include "CCLocaleListener.h"
+#include <map>
+#include <pthread.h>
 
 using namespace std;
 
 NS_CC_BEGIN
 
+/**
+ * A localization key whose hash is computed at compile time, it can only be created
+ * from string literal. If it is a static object, index of key is cached in it and
+ * later lookup is a direct index, until strings are changed.
+ *
+ * \code
+ * static const CCLKey kTitle("shop_title");
+ * label->setString(CCLC(kTitle));
+ * \endcode
+ */
+class CC_DLL CCLKey {
+    friend class CCLocalization;
+    
+private:
+    /// key hash
+    uint64_t m_hash;
+    
+    /// key literal
+    const char* m_key;
+    
+    /// key length
+    size_t m_length;
+    
+    /// cached index, -1 means not found, less than -1 means index in fallback language
+    mutable int m_index;
+    
+    /// generation of localization when index is cached
+    mutable unsigned int m_generation;
+    
+public:
+    template<size_t N>
+    explicit CCLKey(const char (&key)[N]) :
+            m_hash(CCLiteralHash<N, N - 1>::hash(key)),
+            m_key(key),
+            m_length(N - 1),
+            m_index(-1),
+            m_generation(0) {
+    }
+    
+    /// key string
+    const char* getKey() const { return m_key; }
+    
+    /// key hash
+    uint64_t getHash() const { return m_hash; }
+};
+
+/**
+ * argument of localized format, it is converted implicitly from number or string.
+ * String argument only keeps pointer, so it must be valid until format returns.
+ */
+class CC_DLL CCLArg {
+    friend class CCLocalization;
+    
+public:
+    enum Type {
+        INT,
+        DOUBLE,
+        STRING
+    };
+    
+private:
+    Type m_type;
+    int64_t m_int;
+    double m_double;
+    const char* m_string;
+    
+public:
+    CCLArg(int v) : m_type(INT), m_int(v), m_double(0), m_string(NULL) {}
+    CCLArg(unsigned int v) : m_type(INT), m_int(v), m_double(0), m_string(NULL) {}
+    CCLArg(long v) : m_type(INT), m_int(v), m_double(0), m_string(NULL) {}
+    CCLArg(unsigned long v) : m_type(INT), m_int((int64_t)v), m_double(0), m_string(NULL) {}
+    CCLArg(long long v) : m_type(INT), m_int(v), m_double(0), m_string(NULL) {}
+    CCLArg(unsigned long long v) : m_type(INT), m_int((int64_t)v), m_double(0), m_string(NULL) {}
+    CCLArg(float v) : m_type(DOUBLE), m_int(0), m_double(v), m_string(NULL) {}
+    CCLArg(double v) : m_type(DOUBLE), m_int(0), m_double(v), m_string(NULL) {}
+    CCLArg(const char* v) : m_type(STRING), m_int(0), m_double(0), m_string(v ? v : "") {}
+    CCLArg(const string& v) : m_type(STRING), m_int(0), m_double(0), m_string(v.c_str()) {}
+    
+    Type getType() const { return m_type; }
+};
+
 /**
  * localization resource manager and retriever. It can load Android format
  * strings.xml and map all strings. To get a string, just one method with a
  * string key.
+ *
+ * \par
+ * Strings of a language are kept in a \c CCStringTable. Android strings xml can be
+ * compiled to table binary by \c compileAndroidStrings, offline or at first run, then
+ * binary can be loaded by \c addCompiledStrings, which maps file and skips parsing.
+ *
+ * \par
+ * Adding strings only records file location, a language is loaded at first use. When
+ * current language is resolved again, languages other than current one and English
+ * fallback are unloaded. English can be loaded in background by \c preloadLanguage.
+ *
+ * \par
+ * Strings with placeholders can be formatted by \c format, which writes to a caller
+ * buffer without allocation, or by \c formatArgs with an argument array. Placeholders use Android syntax, such as %s, %d, %.2f,
+ * %1$s, %% and %n. Template of a string is parsed at first format and kept until
+ * language is unloaded. Android plurals are selected by CLDR rules of current
+ * language in \c formatPlural.
  */
-class CC_DLL CCLocalization : public CCObject {
+class CC_DLL CCLocalization : public CCObject, public CCLocaleListener {
 private:
     /// singleton
     static CCLocalization* s_instance;
     
-    /// language map, key is language ISO code, value is CCDictionary
-    CCDictionary m_lanMap;
+    /// a registered strings file
+    struct Source {
+        /// file path, platform-independent
+        string path;
+        
+        /// true if it is a compiled table binary, false if it is a strings xml
+        bool compiled;
+    };
+    typedef vector<Source> SourceList;
+    
+    /**
+     * content of a strings file. It is read in gl thread, because CCFileUtils can't
+     * read files in Android apk in other threads, then it can be built in any thread
+     */
+    struct SourceData {
+        /// true if it is a compiled table binary
+        bool compiled;
+        
+        /// true if compiled table is mapped, data is empty
+        bool mapped;
+        
+        /// file content
+        vector<char> data;
+        
+        /// compiled table, mapped in reading or loaded from data in building
+        CCStringTable table;
+    };
+    typedef vector<SourceData*> SourceDataList;
+    
+    /// segment kind of format template, non-negative value is argument index
+    enum {
+        SEGMENT_LITERAL = -1,
+        SEGMENT_NEWLINE = -2
+    };
+    
+    /// a segment of format template
+    struct Segment {
+        /// argument index, or segment kind
+        int arg;
+        
+        /// offset of literal text in value
+        uint32_t offset;
+        
+        /// length of literal text
+        uint32_t length;
+        
+        /// conversion char of argument, such as 's' or 'd'
+        char conversion;
+        
+        /// printf flags, width and precision of argument, including leading '%'
+        char spec[16];
+    };
+    typedef vector<Segment> Template;
+    
+    /// strings of a language
+    struct Language {
+        /// files of this language, later ones override former ones
+        SourceList sources;
+        
+        /// true if table is loaded from sources
+        bool loaded;
+        
+        /// compiled strings
+        CCStringTable table;
+        
+        /// strings returned by getString, created at first access, indexed by table index
+        vector<string*> strings;
+        
+        /// format templates, created at first format, indexed by table index
+        vector<Template*> templates;
+        
+        Language();
+        ~Language();
+        
+        /// delete created strings, must be called after table is changed
+        void reset();
+        
+        /// release table and created strings, it will be loaded again at next use
+        void unload();
+        
+        /// get string at a table index, create it if not yet
+        const string& stringAt(int index);
+        
+        /// get format template at a table index, parse it if not yet
+        const Template& templateAt(int index);
+    };
+    typedef map<string, Language*> LanguageMap;
+    
+    /// work shared by batch threads
+    struct BatchJob;
+    
+    /// language map, key is language ISO code
+    LanguageMap m_lanMap;
+    
+    /// strings of current language, resolved once until invalidated
+    Language* m_current;
+    
+    /// English strings for fallback, NULL if current language is English
+    Language* m_fallback;
+    
+    /// true if current language needs to be resolved again
+    bool m_dirty;
+    
+    /// increased when language is resolved, index cached in CCLKey is valid in same generation
+    unsigned int m_generation;
+    
+    /// ISO code of current language, used to select plural
+    string m_currentCode;
+    
+    /// returned placeholders of missing keys, key is string key, kept forever
+    map<string, string> m_missing;
+    
+    /// guards loaded table of languages, between gl thread and preload thread
+    pthread_mutex_t m_mutex;
+    
+    /// preload thread
+    pthread_t m_preloadThread;
+    
+    /// true if preload thread is running or not joined
+    bool m_preloading;
+    
+    /// file content of preloading language, read before preload thread starts
+    SourceDataList m_preloadData;
     
 protected:
     CCLocalization();
     
+    /// find strings of current language and fallback language
+    void resolveLanguage();
+    
+    /// get language by ISO code, or NULL if not found
+    Language* findLanguage(const string& lan);
+    
+    /// find a key in current language and fallback, returns language which has the key
+    Language* findKey(const char* key, size_t len, int* index);
+    
+    /// find a compile time key, returns language which has the key
+    Language* findKey(const CCLKey& key, int* index);
+    
+    /// get placeholder of a missing key
+    const string& getMissing(const char* key, size_t len);
+    
+    /// find a plural item of a key, returns language which has the item
+    Language* findPlural(const char* key, size_t len, uint64_t keyHash, int64_t quantity, int* index);
+    
+    /// format a string in a language, or write missing placeholder if language is NULL
+    int formatIndex(char* buf, size_t size, Language* l, int index, const char* key, size_t len,
+                    const CCLArg* args, int argc);
+    
+    /// parse Android format string to segments
+    static void parseTemplate(const char* value, size_t len, Template& t);
+    
+    /// add a strings file to a language
+    void addSource(const string& lan, const string& path, bool compiled, bool merge);
+    
+    /// load language table if not loaded
+    void ensureLoaded(Language* l);
+    
+    /// wait preload thread
+    void joinPreload();
+    
+    /// load sources to a table, it must be called in gl thread
+    static bool loadSources(const SourceList& sources, CCStringTable& table);
+    
+    /// read content of sources, it must be called in gl thread
+    static void readSources(const SourceList& sources, SourceDataList& out);
+    
+    /// build a table from read sources, it can be called in any thread
+    static bool buildSources(SourceDataList& sources, CCStringTable& table);
+    
+    /// delete read sources
+    static void releaseSources(SourceDataList& sources);
+    
+    /// entry of preload thread
+    static void* preloadThread(void* arg);
+    
+    /// entry of batch worker thread
+    static void* batchThread(void* arg);
+    
 public:
     virtual ~CCLocalization();
     static CCLocalization* sharedLocalization();
@@ -65,15 +340,215 @@ public:
      *      if strings of this language already exists.
      */
     void addAndroidStrings(const string& lan, const string& path, bool merge = false);
+    
+    /**
+     * register strings compiled by \c compileAndroidStrings. If it is the only file
+     * of language, it is mapped to memory if possible.
+     *
+     * @param lan language ISO 639-1 two-letter code
+     * @param path binary file path, platform-independent
+     * @param merge same as \c addAndroidStrings
+     */
+    void addCompiledStrings(const string& lan, const string& path, bool merge = false);
+    
+    /// a strings file in batch
+    struct StringsFile {
+        /// language ISO 639-1 two-letter code
+        string lan;
+        
+        /// file path, platform-independent
+        string path;
+        
+        /// merge or replace, same as \c addAndroidStrings
+        bool merge;
+        
+        /// true if file is compiled by \c compileAndroidStrings
+        bool compiled;
+        
+        StringsFile(const string& _lan, const string& _path, bool _merge = false, bool _compiled = false) :
+                lan(_lan),
+                path(_path),
+                merge(_merge),
+                compiled(_compiled) {
+        }
+    };
+    typedef vector<StringsFile> StringsFileList;
+    
+    /**
+     * register and load many strings files at once. Files are read in calling thread, because
+     * files in Android apk can't be read in other threads, then they are parsed concurrently
+     * in worker threads, then tables of every language are merged and compiled concurrently, in file
+     * order and with same merge or replace semantics as \c addAndroidStrings. All new tables
+     * are published together after all work is done, so no reader sees a half merged table.
+     * It must be called in gl thread and it returns after all done.
+     *
+     * @param files strings files
+     * @param threads thread count including calling thread, zero means
+     *      \c CCCpuInfo::getRecommendedWorkerCount
+     */
+    void addStringsBatch(const StringsFileList& files, int threads = 0);
+    
+    /**
+     * compile an Android strings xml to string table binary
+     *
+     * @param xmlPath string XML file path, platform-independent
+     * @param outPath binary file path, platform-independent
+     * @return true means successful
+     */
+    static bool compileAndroidStrings(const string& xmlPath, const string& outPath);
 
     /**
      * Get a string by key, in current language. If current language is not English and
      * string is not found, it will try to fallback to English.
      *
+     * \note
+     * Current language is resolved at first call and cached, it is resolved again when
+     * \c CCLocale reports a locale change.
+     *
      * @param key string key name
-     * @return string, or empty if key can't be matched
+     * @return string, or key surrounded by '!' if key can't be matched. Placeholder of
+     *      missing key keeps valid forever. Found string keeps valid until its language
+     *      is unloaded, which happens when strings of that language are added again, or
+     *      when it is not current language or English and current language is resolved
+     *      again after a locale change, or \c unloadUnusedLanguages is called. Copy it
+     *      if you need to keep it longer.
+     */
+    const string& getString(const string& key);
+    
+    /// Get a string by key, it avoids creating temporary string key. @see getString
+    const string& getString(const char* key);
+    
+    /**
+     * Get a string by compile time key. Key is found by its hash, and index is cached
+     * in key. In debug build, key string is compared to detect hash collision.
      */
-    string getString(const string& key);
+    const string& getString(const CCLKey& key);
+    
+    /**
+     * Get a string by key without any allocation, it is same as \c getString except
+     * it returns NULL if key can't be matched
+     */
+    const char* getCString(const char* key, size_t len);
+    
+    /// Get a string by key without any allocation, @see getCString
+    const char* getCString(const char* key) { return getCString(key, strlen(key)); }
+    
+    /// Get a string by compile time key without any allocation, @see getCString
+    const char* getCString(const CCLKey& key);
+    
+    /**
+     * format a localized string into a buffer with an argument array, without allocation.
+     * It has a different name so that a literal 0 argument of \c format is never taken
+     * as NULL array
+     *
+     * @param buf buffer
+     * @param size size of buffer, result is truncated if buffer is small
+     * @param key string key name
+     * @param args arguments
+     * @param argc count of arguments
+     * @return length of result, not including terminating zero
+     */
+    int formatArgs(char* buf, size_t size, const char* key, const CCLArg* args, int argc);
+    
+    /// format a localized string with compile time key, @see formatArgs
+    int formatArgs(char* buf, size_t size, const CCLKey& key, const CCLArg* args, int argc);
+    
+    /// format without argument, key can be a C string or \c CCLKey, @see formatArgs
+    template<typename K>
+    int format(char* buf, size_t size, const K& key) {
+        return formatArgs(buf, size, key, NULL, 0);
+    }
+    
+    /// format with one argument
+    template<typename K>
+    int format(char* buf, size_t size, const K& key, const CCLArg& a1) {
+        return formatArgs(buf, size, key, &a1, 1);
+    }
+    
+    /// format with two arguments
+    template<typename K>
+    int format(char* buf, size_t size, const K& key, const CCLArg& a1, const CCLArg& a2) {
+        CCLArg args[] = { a1, a2 };
+        return formatArgs(buf, size, key, args, 2);
+    }
+    
+    /// format with three arguments
+    template<typename K>
+    int format(char* buf, size_t size, const K& key, const CCLArg& a1, const CCLArg& a2, const CCLArg& a3) {
+        CCLArg args[] = { a1, a2, a3 };
+        return formatArgs(buf, size, key, args, 3);
+    }
+    
+    /// format with four arguments
+    template<typename K>
+    int format(char* buf, size_t size, const K& key, const CCLArg& a1, const CCLArg& a2, const CCLArg& a3, const CCLArg& a4) {
+        CCLArg args[] = { a1, a2, a3, a4 };
+        return formatArgs(buf, size, key, args, 4);
+    }
+    
+    /**
+     * format a plural item with an argument array. Item is selected by quantity with
+     * plural rule of current language, and falls back to "other" item.
+     *
+     * @param buf buffer
+     * @param size size of buffer, result is truncated if buffer is small
+     * @param key plurals name
+     * @param quantity quantity to select plural item
+     * @param args arguments, if NULL, quantity is the only argument
+     * @param argc count of arguments
+     * @return length of result, not including terminating zero
+     */
+    int formatPluralArgs(char* buf, size_t size, const char* key, int64_t quantity, const CCLArg* args, int argc);
+    
+    /// format a plural item with compile time key, @see formatPluralArgs
+    int formatPluralArgs(char* buf, size_t size, const CCLKey& key, int64_t quantity, const CCLArg* args, int argc);
+    
+    /// format a plural item, quantity is the only argument, @see formatPluralArgs
+    template<typename K>
+    int formatPlural(char* buf, size_t size, const K& key, int64_t quantity) {
+        return formatPluralArgs(buf, size, key, quantity, NULL, 0);
+    }
+    
+    /// format a plural item with one argument
+    template<typename K>
+    int formatPlural(char* buf, size_t size, const K& key, int64_t quantity, const CCLArg& a1) {
+        return formatPluralArgs(buf, size, key, quantity, &a1, 1);
+    }
+    
+    /// format a plural item with two arguments
+    template<typename K>
+    int formatPlural(char* buf, size_t size, const K& key, int64_t quantity, const CCLArg& a1, const CCLArg& a2) {
+        CCLArg args[] = { a1, a2 };
+        return formatPluralArgs(buf, size, key, quantity, args, 2);
+    }
+    
+    /**
+     * get CLDR plural category of an integer quantity
+     *
+     * @param lan language ISO code
+     * @param quantity quantity
+     * @return one of "zero", "one", "two", "few", "many" and "other"
+     */
+    static const char* getPluralCategory(const string& lan, int64_t quantity);
+    
+    /// discard cached current language, it will be resolved again in next \c getString
+    void invalidateLanguage();
+    
+    /// @see CCLocaleListener::onLocaleChanged
+    virtual void onLocaleChanged(const string& language, const string& country);
+    
+    /**
+     * load a language in background thread, so that first use of it doesn't parse file.
+     * Usually it is used to load English fallback. If that language is loaded or not
+     * registered, it does nothing. Files are read in calling thread, because files in
+     * Android apk can't be read in other threads, only parsing is done in background.
+     *
+     * @param lan language ISO 639-1 two-letter code
+     */
+    void preloadLanguage(const string& lan = "en");
+    
+    /// unload all languages except current one and English fallback
+    void unloadUnusedLanguages();
 };
 
 /// macro for easily get strings
@@ -82,6 +557,12 @@ public:
 /// macro to get a C string
 #define CCLC(k) (CCL(k).c_str())
 
+/// macro to get strings by a string literal key, hash of key is computed at compile time
+#define CCLK(k) (CCLocalization::sharedLocalization()->getString(CCLKey("" k)))
+
+/// macro to get a C string by a string literal key
+#define CCLKC(k) (CCLK(k).c_str())
+
 NS_CC_END
 
 #endif /* defined(__CCLocalization_h__) */
@@ -25,13 +25,101 @@
 #define __CCMD5_h__
 
 #include "cocos2d.h"
+#include "CCAssetInputStream.h"
 #include <stddef.h>
+#include <stdint.h>
+#include <string>
+
+using namespace std;
+USING_NS_CC;
+
+/// md5 context, used by incremental api
+typedef struct ccMD5Context {
+	/// state (ABCD)
+	uint32_t state[4];
+	
+	/// number of bits, modulo 2^64 (lsb first)
+	uint32_t count[2];
+	
+	/// input buffer
+	unsigned char buffer[64];
+} ccMD5Context;
 
 /**
  * MD5 utilities
  */
 class CC_DLL CCMD5 {
 public:
+	/**
+	 * initialize a md5 context, must be called before update
+	 *
+	 * @param context md5 context
+	 */
+	static void init(ccMD5Context* context);
+	
+	/**
+	 * feed a block of data into md5 context, it can be called many times
+	 *
+	 * @param context md5 context
+	 * @param data binary data
+	 * @param len data length
+	 */
+	static void update(ccMD5Context* context, const void* data, size_t len);
+	
+	/**
+	 * finish md5 calculation and output binary digest. After this call, the context
+	 * is cleared and must be initialized again before reuse
+	 *
+	 * @param context md5 context
+	 * @param digest buffer to hold 16 bytes binary digest
+	 */
+	static void final(ccMD5Context* context, unsigned char digest[16]);
+	
+	/**
+	 * convert a binary digest to md5 string
+	 *
+	 * @param digest 16 bytes binary digest
+	 * @return md5 string, caller should release it
+	 */
+	static const char* toHex(const unsigned char digest[16]);
+	
+	/**
+	 * convert a binary digest to md5 string, without allocation
+	 *
+	 * @param digest 16 bytes binary digest
+	 * @param hex buffer to hold 32 hex characters and null terminator
+	 */
+	static void toHex(const unsigned char digest[16], char hex[33]);
+	
+	/**
+	 * calculate md5 digest for remaining data of a stream. The stream is read
+	 * in fixed-size chunks so the memory used is constant
+	 *
+	 * @param is input stream, it is read from current position to end
+	 * @param digest buffer to hold 16 bytes binary digest
+	 * @return true means successful, false means stream reports a read error
+	 */
+	static bool md5Stream(CCAssetInputStream* is, unsigned char digest[16]);
+	
+	/**
+	 * calculate md5 digest for a file. If the file can be opened as a local
+	 * file, it will be read in fixed-size chunks. Otherwise it falls back to
+	 * \c CCAssetInputStream, which is the case for files in Android apk
+	 *
+	 * @param path file path, it will be mapped by \c CCUtils::mapLocalPath
+	 * @param digest buffer to hold 16 bytes binary digest
+	 * @return true means successful
+	 */
+	static bool md5File(const string& path, unsigned char digest[16]);
+	
+	/**
+	 * calculate md5 string for a file
+	 *
+	 * @param path file path, it will be mapped by \c CCUtils::mapLocalPath
+	 * @return md5 string, caller should release it. NULL if file can't be read
+	 */
+	static const char* md5File(const string& path);
+	
 	/**
 	 * calculate md5 string for a C string
 	 *
@@ -48,6 +136,28 @@ public:
 	 * @return md5 string, caller should release it
 	 */
 	static const char* md5(const void* data, size_t len);
+	
+	/**
+	 * calculate md5 for a binary data, without allocation
+	 *
+	 * @param data binary data
+	 * @param len data length
+	 * @param hex buffer to hold 32 hex characters and null terminator
+	 */
+	static void md5(const void* data, size_t len, char hex[33]);
+	
+	/**
+	 * calculate md5 for many independent buffers at once. When SSE2 or NEON is
+	 * available, buffers are hashed in parallel SIMD lanes, otherwise it hashes
+	 * them one by one. Result is same as calling md5 for every buffer, and it
+	 * is much faster for a lot of small buffers
+	 *
+	 * @param data buffer pointer array
+	 * @param len buffer length array
+	 * @param count number of buffers
+	 * @param digests array to hold \c count 16 bytes binary digests
+	 */
+	static void md5Batch(const void* const* data, const size_t* len, size_t count, unsigned char (*digests)[16]);
 };
 
 #endif // __CCMD5_h__
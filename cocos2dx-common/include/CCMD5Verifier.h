@@ -0,0 +1,158 @@
+/****************************************************************************
+ Author: Luma (stubma@gmail.com)
+ 
+ https://github.com/stubma/cocos2dx-common
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ ****************************************************************************/
+#ifndef __CCMD5Verifier_h__
+#define __CCMD5Verifier_h__
+
+#include "cocos2d.h"
+#include "CCMD5VerifierListener.h"
+#include <pthread.h>
+#include <stdint.h>
+#include <vector>
+
+using namespace std;
+
+NS_CC_BEGIN
+
+/**
+ * Verify a manifest of files, every entry has path, size and md5. Files are
+ * checked by a group of worker threads, each reads file in big sequential
+ * chunks and hashes it with \c CCMD5. Size is checked first so a truncated
+ * file fails without being hashed.
+ *
+ * \note
+ * Entries must be local files, files in Android apk can't be read in worker thread
+ */
+class CC_DLL CCMD5Verifier : public CCObject {
+public:
+	/// verify result of a file
+	enum Result {
+		/// file is good
+		OK,
+		
+		/// file can't be opened or read
+		MISSING,
+		
+		/// file size doesn't match
+		SIZE_MISMATCH,
+		
+		/// md5 doesn't match
+		MD5_MISMATCH
+	};
+	
+private:
+	/// manifest entry
+	struct Entry {
+		/// path in manifest
+		string path;
+		
+		/// mapped local path
+		string localPath;
+		
+		/// expected size, -1 means don't check
+		int64_t size;
+		
+		/// expected md5 string
+		string md5;
+	};
+	
+	/// entry list
+	typedef vector<Entry> EntryList;
+	EntryList m_entries;
+	
+	/// listener
+	CCMD5VerifierListener* m_listener;
+	
+	/// next entry to verify
+	size_t m_next;
+	
+	/// failed file count
+	int m_failed;
+	
+	/// cancel flag, guarded by m_cancelMutex
+	bool m_cancelled;
+	
+	/// lock of next index, counter and listener
+	pthread_mutex_t m_mutex;
+	
+	/// lock of cancel flag, separated so that listener can cancel in callback
+	pthread_mutex_t m_cancelMutex;
+	
+protected:
+	CCMD5Verifier(CCMD5VerifierListener* listener);
+	
+	/// worker thread entry
+	static void* workerThread(void* arg);
+	
+	/// verify one file
+	int verifyEntry(const Entry& e, char* buffer, size_t bufferSize);
+	
+public:
+	virtual ~CCMD5Verifier();
+	
+	/**
+	 * create a verifier
+	 *
+	 * @param listener listener to get result of every file, can be NULL
+	 * @return verifier instance
+	 */
+	static CCMD5Verifier* create(CCMD5VerifierListener* listener = NULL);
+	
+	/**
+	 * add an entry of manifest
+	 *
+	 * @param path file path, it will be mapped by \c CCUtils::mapLocalPath
+	 * @param size expected file size, -1 means don't check size
+	 * @param md5 expected md5 string, case insensitive
+	 */
+	void addEntry(const string& path, int64_t size, const string& md5);
+	
+	/// remove all entries
+	void removeAllEntries();
+	
+	/**
+	 * verify all entries, it blocks until all files are checked or verification
+	 * is cancelled
+	 *
+	 * @param threads worker thread count, 0 means \c CCCpuInfo::getRecommendedWorkerCount
+	 * @return true means all files are good, false means some files fail or verification
+	 *      is cancelled
+	 */
+	bool verify(int threads = 0);
+	
+	/// cancel verification, it is thread safe. Files being hashed will be finished
+	void cancel();
+	
+	/// is cancelled?
+	bool isCancelled();
+	
+	/// failed file count of last verification
+	int getFailedCount() { return m_failed; }
+	
+	/// entry count
+	size_t getEntryCount() { return m_entries.size(); }
+};
+
+NS_CC_END
+
+#endif // __CCMD5Verifier_h__
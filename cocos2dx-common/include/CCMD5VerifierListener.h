@@ -0,0 +1,56 @@
+/****************************************************************************
+ Author: Luma (stubma@gmail.com)
+ 
+ https://github.com/stubma/cocos2dx-common
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ ****************************************************************************/
+#ifndef __CCMD5VerifierListener_h__
+#define __CCMD5VerifierListener_h__
+
+#include "cocos2d.h"
+#include <string>
+
+using namespace std;
+
+NS_CC_BEGIN
+
+class CCMD5Verifier;
+
+/**
+ * listener to get result of every file checked by \c CCMD5Verifier, a pure
+ * virtual class act as an interface
+ */
+class CC_DLL CCMD5VerifierListener {
+public:
+	/**
+	 * notified when a file is verified. It is called in worker thread, but calls
+	 * are serialized so listener doesn't need its own lock. Calling \c CCMD5Verifier::cancel
+	 * here is allowed, to stop at first failure
+	 *
+	 * @param verifier the verifier
+	 * @param path file path in manifest
+	 * @param result one of \c CCMD5Verifier::Result
+	 */
+	virtual void onFileVerified(CCMD5Verifier* verifier, const string& path, int result) = 0;
+};
+
+NS_CC_END
+
+#endif // __CCMD5VerifierListener_h__
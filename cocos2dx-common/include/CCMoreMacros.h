@@ -65,6 +65,23 @@ using namespace std;
 	#define htobe32 CFSwapInt32HostToBig
 	#define htobe16 CFSwapInt16HostToBig
 
+    // path separator
+    #define CC_PATH_SEPARATOR '/'
+
+	// max float
+	#define MAX_FLOAT 3.4028235E38f
+#elif CC_TARGET_PLATFORM == CC_PLATFORM_LINUX
+    #include <sys/stat.h>
+	#include <endian.h>
+
+    // endian, glibc names are different from bsd
+	#define letoh64 le64toh
+	#define letoh32 le32toh
+	#define letoh16 le16toh
+	#define betoh64 be64toh
+	#define betoh32 be32toh
+	#define betoh16 be16toh
+
     // path separator
     #define CC_PATH_SEPARATOR '/'
 
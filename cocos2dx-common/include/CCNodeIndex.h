@@ -0,0 +1,126 @@
+/****************************************************************************
+ Author: Luma (stubma@gmail.com)
+ 
+ https://github.com/stubma/cocos2dx-common
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ ****************************************************************************/
+#ifndef __CCNodeIndex_h__
+#define __CCNodeIndex_h__
+
+#include "cocos2d.h"
+#include <vector>
+
+using namespace std;
+
+NS_CC_BEGIN
+
+/**
+ * A flattened index of a node subtree. It collects root and all descendants in
+ * pre-order into a contiguous array, and remembers which of them implement
+ * \c CCRGBAProtocol, so bulk operations don't need to walk the tree and cast
+ * every node. Indexed nodes are retained so index never holds a dangling node.
+ *
+ * \par
+ * By default, index checks tree structure before every bulk operation and rebuilds
+ * itself if any child is added, removed or reordered. The check only compares node
+ * pointers and is much cheaper than a cast per node. If you know when tree changes,
+ * disable auto validation and call \c invalidate by yourself, then a bulk operation
+ * is only a loop over array
+ */
+class CC_DLL CCNodeIndex : public CCObject {
+private:
+	/// root node
+	CCNode* m_root;
+	
+	/// all nodes in pre-order, retained
+	vector<CCNode*> m_nodes;
+	
+	/// nodes which implements rgba protocol
+	vector<CCRGBAProtocol*> m_rgbaNodes;
+	
+	/// index should be rebuilt
+	bool m_dirty;
+	
+	/// check tree structure before every operation
+	bool m_autoValidate;
+	
+protected:
+	CCNodeIndex(CCNode* root);
+	
+	/// release indexed nodes
+	void clear();
+	
+	/// collect nodes from tree
+	void rebuild();
+	
+	/// collect a node and its descendants
+	void collect(CCNode* n);
+	
+	/// check a node and its descendants match index from position pos
+	bool matches(CCNode* n, size_t& pos);
+	
+	/// make sure index is up to date
+	void ensureValid();
+	
+public:
+	virtual ~CCNodeIndex();
+	
+	/**
+	 * create an index for a subtree
+	 *
+	 * @param root root of subtree, it is retained by index
+	 * @return index instance, autoreleased
+	 */
+	static CCNodeIndex* create(CCNode* root);
+	
+	/// mark index as out of date, it will be rebuilt at next operation
+	void invalidate() { m_dirty = true; }
+	
+	/// set opacity of all rgba nodes
+	void setOpacity(GLubyte o);
+	
+	/// set color of all rgba nodes
+	void setColor(const ccColor3B& c);
+	
+	/// set visibility of all nodes, includes root
+	void setVisible(bool v);
+	
+	/// get root node
+	CCNode* getRoot() { return m_root; }
+	
+	/// count of indexed nodes, includes root
+	size_t getNodeCount();
+	
+	/// count of indexed nodes which implements rgba protocol
+	size_t getRGBANodeCount();
+	
+	/// get node by pre-order index
+	CCNode* getNodeAt(size_t index);
+	
+	/// enable or disable structure check before every operation, default is enabled
+	void setAutoValidate(bool flag) { m_autoValidate = flag; }
+	
+	/// is auto validation enabled
+	bool isAutoValidate() { return m_autoValidate; }
+};
+
+NS_CC_END
+
+#endif // __CCNodeIndex_h__
@@ -0,0 +1,152 @@
+/****************************************************************************
+ Author: Luma (stubma@gmail.com)
+ 
+ https://github.com/stubma/cocos2dx-common
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ ****************************************************************************/
+#ifndef __CCPath_h__
+#define __CCPath_h__
+
+#include "cocos2d.h"
+#include <string>
+#include <map>
+#include <pthread.h>
+
+using namespace std;
+
+NS_CC_BEGIN
+
+/**
+ * An interned and normalized path. Same path always refers to same shared entry,
+ * so copy and comparison are just pointer operations. Entry caches offsets of last
+ * component and extension, parent path and mapped local path, so resolving a path
+ * repeatedly is cheap. Entries are never released, it is designed for a limited set
+ * of asset paths, not for arbitrary strings. It is safe to use in any thread.
+ *
+ * \par
+ * Normalization merges duplicated separators, removes "." component, resolves ".."
+ * component if possible and removes trailing separator. Separator is converted to
+ * platform separator
+ */
+class CC_DLL CCPath {
+private:
+	/// shared entry of a path
+	struct Entry {
+		/// normalized path
+		string path;
+		
+		/// start of last component
+		size_t nameStart;
+		
+		/// index of extension dot in last component, or npos
+		size_t dot;
+		
+		/// parent entry, NULL if not resolved yet
+		Entry* parent;
+		
+		/// mapped local path
+		string localPath;
+		
+		/// local path is mapped
+		bool mapped;
+	};
+	
+	typedef map<string, Entry*> EntryMap;
+	
+private:
+	/// interned entries, key can be raw or normalized path
+	static EntryMap s_entries;
+	
+	/// lock of entries
+	static pthread_mutex_t s_mutex;
+	
+private:
+	/// shared entry
+	Entry* m_entry;
+	
+private:
+	CCPath(Entry* entry) : m_entry(entry) {}
+	static Entry* intern(const string& path);
+	
+public:
+	/// empty path
+	CCPath();
+	
+	CCPath(const char* path);
+	CCPath(const string& path);
+	
+	/**
+	 * normalize a path string without interning
+	 *
+	 * @param path path string
+	 * @return normalized path
+	 */
+	static string normalize(const string& path);
+	
+	/// get normalized path string
+	const string& getPath() const { return m_entry->path; }
+	
+	/// get normalized path as C string
+	const char* c_str() const { return m_entry->path.c_str(); }
+	
+	/// is empty path
+	bool isEmpty() const { return m_entry->path.empty(); }
+	
+	/// get last component, such as "a.png" for "/sdcard/a.png"
+	string getLastPathComponent() const;
+	
+	/// get extension without dot, such as "png" for "/sdcard/a.png"
+	string getPathExtension() const;
+	
+	/// get path without extension
+	string deletePathExtension() const;
+	
+	/// get parent path, such as "/sdcard" for "/sdcard/a.png", it is cached
+	CCPath getParent() const;
+	
+	/// append a component and return new interned path
+	CCPath append(const string& component) const;
+	
+	/**
+	 * get local path mapped by \c CCUtils::mapLocalPath. It is returned by value because
+	 * a mapping which is not fixed is done again in every call and may be different, use
+	 * \c getFixedLocalPath to avoid copy
+	 */
+	string getLocalPath() const;
+	
+	/**
+	 * get local path if its mapping never changes, @see CCUtils::isLocalPathFixed. It
+	 * is cached in entry so returned string keeps valid forever
+	 *
+	 * @return cached local path, or NULL if mapping is not fixed and \c getLocalPath
+	 * must be used
+	 */
+	const string* getFixedLocalPath() const;
+	
+	bool operator==(const CCPath& p) const { return m_entry == p.m_entry; }
+	bool operator!=(const CCPath& p) const { return m_entry != p.m_entry; }
+	
+	/// order by entry address, it is only for using as map key
+	bool operator<(const CCPath& p) const { return m_entry < p.m_entry; }
+};
+
+NS_CC_END
+
+#endif // __CCPath_h__
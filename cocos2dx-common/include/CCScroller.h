@@ -100,9 +100,9 @@ private:
 	float m_currY;
 
 	/**
-	 * start time in millisecond
+	 * start time in millisecond, from frame time of \c CCClock
 	 */
-	int m_startTime;
+	int64_t m_startTime;
 
 	/**
 	 * fling duration time
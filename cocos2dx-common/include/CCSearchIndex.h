@@ -0,0 +1,110 @@
+/****************************************************************************
+ Author: Luma (stubma@gmail.com)
+ 
+ https://github.com/stubma/cocos2dx-common
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ ****************************************************************************/
+#ifndef __CCSearchIndex_h__
+#define __CCSearchIndex_h__
+
+#include "cocos2d.h"
+#include <vector>
+
+using namespace std;
+
+NS_CC_BEGIN
+
+/**
+ * A static search index built once from a sorted int array, for frequent lookups
+ * in big tables. Keys are split into blocks of 16, the maximum key of every block is
+ * stored in Eytzinger (breadth first) order so top levels of search share few cache
+ * lines and can be prefetched, and descending is branchless. Last levels are replaced
+ * by counting keys less than target in a block with SSE2 or NEON.
+ *
+ * \par
+ * Result follows same contract as \c CCUtils::binarySearch, it returns index of key
+ * if found, or -(insertion point + 1) if not found. If there are duplicated keys, index
+ * of first one is returned.
+ */
+class CC_DLL CCSearchIndex {
+private:
+	/// sorted keys, padded to multiple of block size with INT_MAX
+	vector<int> m_keys;
+	
+	/// maximum key of blocks in Eytzinger order, 1-based
+	vector<int> m_tree;
+	
+	/// block index of every tree node
+	vector<int> m_blocks;
+	
+	/// key count
+	size_t m_size;
+	
+private:
+	/// fill tree with in-order traversal, returns next block index
+	size_t buildTree(size_t k, size_t block, const vector<int>& maxKeys);
+	
+public:
+	CCSearchIndex();
+	
+	/**
+	 * build index from a sorted array
+	 *
+	 * @param sorted sorted array in ascending order
+	 * @param len length of array
+	 */
+	CCSearchIndex(const int* sorted, size_t len);
+	
+	/// rebuild index from a sorted array
+	void build(const int* sorted, size_t len);
+	
+	/// key count
+	size_t size() const { return m_size; }
+	
+	/**
+	 * find index of first key which is not less than key
+	 *
+	 * @param key key to search
+	 * @return index of first key not less than key, or size() if all keys are less than key
+	 */
+	size_t lowerBound(int key) const;
+	
+	/**
+	 * search a key
+	 *
+	 * @param key key to search
+	 * @return index of key, or -(insertion point + 1) if not found
+	 */
+	int search(int key) const;
+	
+	/**
+	 * search many keys, it is faster than searching one by one because lookups of
+	 * different keys overlap
+	 *
+	 * @param keys keys to search
+	 * @param count key count
+	 * @param results return result of every key, same as \c search
+	 */
+	void search(const int* keys, size_t count, int* results) const;
+};
+
+NS_CC_END
+
+#endif // __CCSearchIndex_h__
@@ -0,0 +1,259 @@
+/****************************************************************************
+ Author: Luma (stubma@gmail.com)
+ 
+ https://github.com/stubma/cocos2dx-common
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ ****************************************************************************/
+#ifndef __CCStringTable_h__
+#define __CCStringTable_h__
+
+#include "cocos2d.h"
+#include <vector>
+#include <map>
+#include <string>
+
+using namespace std;
+
+NS_CC_BEGIN
+
+/**
+ * 64 bits FNV-1a hash of a string literal, same as \c CCStringTable::hash. It is
+ * unrolled by template so compiler can fold it to a constant. N is array size of
+ * literal, I is count of hashed chars.
+ */
+template<size_t N, size_t I>
+struct CCLiteralHash {
+	static inline uint64_t hash(const char (&s)[N]) {
+		return (CCLiteralHash<N, I - 1>::hash(s) ^ (unsigned char)s[I - 1]) * 0x100000001b3ULL;
+	}
+};
+
+/// FNV-1a offset basis, end of recursion
+template<size_t N>
+struct CCLiteralHash<N, 0> {
+	static inline uint64_t hash(const char (&)[N]) {
+		return 0xcbf29ce484222325ULL;
+	}
+};
+
+/**
+ * An immutable string table compiled from key-value pairs. Keys and values are saved in
+ * a UTF-8 blob, and keys are indexed by a minimal perfect hash (hash and displace), so
+ * a lookup costs one hash of key and two memory reads, without any allocation.
+ *
+ * \par
+ * Compiled table can be saved to a binary file, and loaded later. If file is a real file
+ * in file system, it is mapped to memory instead of read. Binary file uses host byte
+ * order, so it must be compiled for target, or compiled at first run.
+ *
+ * \par
+ * Every key is identified by 64 bits FNV-1a hash, the builder refuses keys whose
+ * hash collides with another key. So a key can be found by its hash only, which can
+ * be computed ahead of time.
+ */
+class CC_DLL CCStringTable {
+public:
+	/// collects key-value pairs and compiles them to table
+	class CC_DLL Builder {
+	private:
+		/// entry in builder, offsets are in blob
+		struct Entry {
+			uint64_t hash;
+			uint32_t key;
+			uint32_t keyLength;
+			uint32_t value;
+			uint32_t valueLength;
+		};
+		
+		/// key and value bytes, every string is zero terminated
+		vector<char> m_blob;
+		
+		/// entries in adding order
+		vector<Entry> m_entries;
+		
+		/// key hash to entry index
+		map<uint64_t, size_t> m_index;
+		
+		/// count of replaced entries, they are skipped when compiling
+		size_t m_replaced;
+		
+	private:
+		/// append string to blob, returns offset
+		uint32_t appendString(const char* s, size_t len);
+		
+	public:
+		Builder();
+		
+		/**
+		 * add a key-value pair. If key already exists, value is replaced.
+		 *
+		 * @param key key, needn't be zero terminated
+		 * @param keyLength length of key in bytes
+		 * @param value value, needn't be zero terminated
+		 * @param valueLength length of value in bytes
+		 * @return false if key hash collides with a different key
+		 */
+		bool add(const char* key, size_t keyLength, const char* value, size_t valueLength);
+		
+		/// add a key-value pair, @see add
+		bool add(const string& key, const string& value) {
+			return add(key.c_str(), key.length(), value.c_str(), value.length());
+		}
+		
+		/// add all pairs in a table, existing keys are replaced
+		void addTable(const CCStringTable& table);
+		
+		/// add all pairs in another builder, existing keys are replaced
+		void addBuilder(const Builder& builder);
+		
+		/// unique key count
+		size_t size() const { return m_entries.size() - m_replaced; }
+		
+		/// remove all pairs
+		void clear();
+		
+		/**
+		 * compile pairs to table binary
+		 *
+		 * @param out receives binary data, it can be saved to file or loaded by \c CCStringTable::loadData
+		 * @return true means successful
+		 */
+		bool compile(vector<char>& out) const;
+	};
+	
+private:
+	struct Header;
+	struct Slot;
+	
+	/// data owned by table, if not mapped
+	vector<char> m_owned;
+	
+	/// mapped file address, or NULL
+	void* m_mapped;
+	
+	/// mapped length
+	size_t m_mappedLength;
+	
+	/// table header, NULL if empty
+	const Header* m_header;
+	
+	/// displacement of every bucket
+	const uint32_t* m_seeds;
+	
+	/// slots, indexed by perfect hash
+	const Slot* m_slots;
+	
+	/// string blob
+	const char* m_blob;
+	
+private:
+	// not copyable
+	CCStringTable(const CCStringTable&);
+	CCStringTable& operator=(const CCStringTable&);
+	
+	/// validate data and set pointers, returns false if data is corrupted
+	bool attach(const char* data, size_t length);
+	
+public:
+	CCStringTable();
+	~CCStringTable();
+	
+	/**
+	 * 64 bits FNV-1a hash of a key
+	 *
+	 * @param key key
+	 * @param len length of key
+	 * @param seed FNV offset basis by default, or hash of a prefix to hash prefix + key
+	 * @return hash
+	 */
+	static uint64_t hash(const char* key, size_t len, uint64_t seed = 0xcbf29ce484222325ULL);
+	
+	/// compile a builder and load result
+	bool build(const Builder& builder);
+	
+	/**
+	 * load table binary, data is swapped into table so no copy is made
+	 *
+	 * @param data binary compiled by \c Builder::compile, it is empty after return
+	 * @return false if data is not a valid table
+	 */
+	bool loadData(vector<char>& data);
+	
+	/**
+	 * load table binary from file. The path is platform-independent, same as
+	 * \c CCUtils::mapLocalPath. If it is a real file, it is mapped instead of read.
+	 *
+	 * @param path binary file path
+	 * @return false if file can't be read or it is not a valid table
+	 */
+	bool loadFile(const string& path);
+	
+	/**
+	 * map table binary file, same as \c loadFile except it never reads file by
+	 * \c CCFileUtils, so it can be called in any thread
+	 *
+	 * @param path binary file path
+	 * @return false if it is not a real file, or it is not a valid table
+	 */
+	bool mapFile(const string& path);
+	
+	/// save table binary to a file, the path is platform-independent
+	bool save(const string& path) const;
+	
+	/// release data, table becomes empty
+	void unload();
+	
+	/// exchange data with another table, no copy is made
+	void swap(CCStringTable& t);
+	
+	/// key count
+	size_t size() const;
+	
+	/**
+	 * find index of a key by its hash, key string is not compared
+	 *
+	 * @param h key hash returned by \c hash
+	 * @return index of key, or -1 if not found
+	 */
+	int indexOfHash(uint64_t h) const;
+	
+	/// find index of a key, or -1 if not found
+	int indexOf(const char* key, size_t len) const;
+	
+	/// key at an index, zero terminated
+	const char* keyAt(int index, size_t* len = NULL) const;
+	
+	/// value at an index, zero terminated
+	const char* valueAt(int index, size_t* len = NULL) const;
+	
+	/**
+	 * lookup value of a key
+	 *
+	 * @param key key
+	 * @param len length of key
+	 * @param valueLength receives length of value, can be NULL
+	 * @return zero terminated value, or NULL if key is not found
+	 */
+	const char* lookup(const char* key, size_t len, size_t* valueLength = NULL) const;
+};
+
+NS_CC_END
+
+#endif // __CCStringTable_h__
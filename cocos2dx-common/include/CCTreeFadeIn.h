@@ -25,19 +25,25 @@
 #define __CCTreeFadeIn_h__
 
 #include "cocos2d.h"
+#include "CCNodeIndex.h"
 
 NS_CC_BEGIN
 
 /// fade in action which also fade in all descendants
 class CC_DLL CCTreeFadeIn : public CCFadeIn {
 protected:
-    /// fade in recursively
-    void fadeInRecursively(CCNode* n, float time);
+    /// index of target subtree, so rgba descendants are not searched every frame
+    CCNodeIndex* m_index;
     
 public:
+    CCTreeFadeIn();
+    virtual ~CCTreeFadeIn();
+    
     /** creates the action */
     static CCTreeFadeIn* create(float d);
     
+    virtual void startWithTarget(CCNode* pTarget);
+    virtual void stop();
     virtual void update(float time);
     virtual CCActionInterval* reverse(void);
 };
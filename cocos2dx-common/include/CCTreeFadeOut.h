@@ -25,19 +25,25 @@
 #define __CCTreeFadeOut_h__
 
 #include "cocos2d.h"
+#include "CCNodeIndex.h"
 
 NS_CC_BEGIN
 
 /// fade out action which also fade out all descendants
 class CC_DLL CCTreeFadeOut : public CCFadeOut {
 protected:
-    /// fade out recursively
-    void fadeOutRecursively(CCNode* n, float time);
+    /// index of target subtree, so rgba descendants are not searched every frame
+    CCNodeIndex* m_index;
     
 public:
+    CCTreeFadeOut();
+    virtual ~CCTreeFadeOut();
+    
     /** creates the action */
     static CCTreeFadeOut* create(float d);
     
+    virtual void startWithTarget(CCNode* pTarget);
+    virtual void stop();
     virtual void update(float time);
     virtual CCActionInterval* reverse(void);
 };
@@ -40,6 +40,146 @@ class CC_DLL CCUtils {
 public:
     typedef vector<string> StringList;
     
+    /// file information returned by statPaths
+    struct FileStat {
+        /// path is existent
+        bool exists;
+        
+        /// path is a folder
+        bool directory;
+        
+        /// file size in bytes
+        int64_t size;
+        
+        /// last modification time, seconds from 1970-1-1
+        int64_t modifyTime;
+    };
+    
+    /**
+     * iterate components of a string without allocation. It follows same rule
+     * as componentsOfString, but every component is returned as a pointer and
+     * length pointing into source string, which is not null terminated. It doesn't
+     * touch any shared state so it is safe in any thread.
+     *
+     * \par
+     * Usage:
+     * <pre>
+     * CCUtils::ComponentIterator iter(s, ',');
+     * const char* comp;
+     * size_t len;
+     * while(iter.next(&comp, &len)) {
+     *     ...
+     * }
+     * </pre>
+     *
+     * \note
+     * The source string must be alive and unchanged during iteration
+     */
+    class CC_DLL ComponentIterator {
+    private:
+        /// current position
+        const char* m_cur;
+        
+        /// end of content, braces excluded
+        const char* m_end;
+        
+        /// separator
+        char m_sep;
+        
+        /// no more component
+        bool m_done;
+        
+    private:
+        void init(const char* s, size_t len, char sep);
+        
+    public:
+        ComponentIterator(const char* s, size_t len, char sep) { init(s, len, sep); }
+        ComponentIterator(const string& s, char sep) { init(s.c_str(), s.length(), sep); }
+        
+        /**
+         * get next component
+         *
+         * @param comp return start of component
+         * @param len return length of component
+         * @return false means no more component
+         */
+        bool next(const char** comp, size_t* len);
+    };
+    
+    /**
+     * a list of typed values, it is the light version of CCArray used by
+     * arrayFromString and arrayToString. Numbers are saved in place and strings
+     * are saved in one shared pool, so no CCObject is created for element. Call
+     * clear to reuse it and its memory will be kept.
+     */
+    class CC_DLL ValueArray {
+    public:
+        /// type of value
+        enum Type {
+            FLOAT,
+            DOUBLE,
+            INTEGER,
+            STRING
+        };
+        
+    private:
+        /// a value
+        struct Value {
+            Type type;
+            
+            /// number value, or string offset in pool
+            union {
+                float f;
+                double d;
+                int i;
+                size_t offset;
+            } v;
+            
+            /// string length
+            size_t length;
+        };
+        
+        /// values
+        vector<Value> m_values;
+        
+        /// string pool, every string is null terminated in it
+        string m_pool;
+        
+    public:
+        /// remove all values but keep memory
+        void clear() { m_values.clear(); m_pool.clear(); }
+        
+        /// value count
+        size_t size() const { return m_values.size(); }
+        
+        /// type of value at index
+        Type getType(size_t index) const { return m_values[index].type; }
+        
+        void addFloat(float f);
+        void addDouble(double d);
+        void addInteger(int i);
+        void addString(const char* s, size_t len);
+        void addString(const string& s) { addString(s.c_str(), s.length()); }
+        
+        /// get value as float, string is parsed
+        float getFloat(size_t index) const;
+        
+        /// get value as double, string is parsed
+        double getDouble(size_t index) const;
+        
+        /// get value as int, string is parsed
+        int getInteger(size_t index) const;
+        
+        /**
+         * get string value, it is null terminated and valid until array is modified.
+         * For non-string value, it returns empty string
+         */
+        const char* getString(size_t index) const;
+        
+        /// get string length, 0 for non-string value
+        size_t getStringLength(size_t index) const;
+    };
+    
 private:
     /// string list temp
     static StringList s_tmpStringList;
@@ -94,7 +234,7 @@ public:
     static int getNumDigits(int num);
     
     /// Get index of last slash character, if not found, returns -1
-    static ssize_t lastSlashIndex(string path);
+    static ssize_t lastSlashIndex(const string& path);
     
     /// Get index of last dot character, if not found, returns -1
     static ssize_t lastDotIndex(const string& path);
@@ -148,8 +288,22 @@ public:
 	 * a path "sdcard/a.png" will be:
 	 * 1. in iOS, it will be [app path]/sdcard/a.png
 	 * 2. in Mac OS X, it will [app path]/Contents/Resources/sdcard/a.png
+	 *
+	 * Mapped result is remembered so same path is only resolved once if its mapping
+	 * is fixed, @see isLocalPathFixed. It is safe to call it in any thread. If you need
+	 * to avoid copy, use \c CCPath::getFixedLocalPath
+	 */
+	static string mapLocalPath(const string& path);
+	
+	/**
+	 * check whether mapping of a path never changes during app lifetime. It is false
+	 * for relative path in Linux, because it is searched in resource folders and result
+	 * depends on search paths and file existence
 	 */
-	static string mapLocalPath(string path);
+	static bool isLocalPathFixed(const string& path);
+	
+	/// clear memo of mapLocalPath, only needed if you want to release memory
+	static void purgeLocalPathCache();
 	
 	/// get parent path of a path
 	static string getParentPath(string path);
@@ -182,6 +336,24 @@ public:
 	 */
 	static bool isPathExistent(string path);
 	
+	/**
+	 * query information of many paths in one call. Paths are mapped by mapLocalPath.
+	 * On Android and Linux, adjacent paths in same folder share one opened folder
+	 * so sort paths by folder to get best speed
+	 *
+	 * @param paths path list
+	 * @param out information of every path, in same order of paths
+	 */
+	static void statPaths(const StringList& paths, vector<FileStat>& out);
+	
+	/**
+	 * check existence of many paths in one call, @see statPaths
+	 *
+	 * @param paths path list
+	 * @param out existence of every path, in same order of paths
+	 */
+	static void arePathsExistent(const StringList& paths, vector<bool>& out);
+	
 	/**
 	 * create a folder at specified absolute path, its parent folder should be existent and this
 	 * method won't perform checking
@@ -200,6 +372,44 @@ public:
 	/// convert hsv to rgb
 	static ccColor3B hsv2ccc3(ccColorHSV c);
 	
+	/**
+	 * convert many rgb colors to hsv, it uses SSE2 or NEON when available and result
+	 * is bit-identical to converting one by one with ccc32hsv
+	 *
+	 * @param src rgb colors
+	 * @param dst hsv colors, must hold count colors
+	 * @param count color count
+	 */
+	static void ccc32hsv(const ccColor3B* src, ccColorHSV* dst, size_t count);
+	
+	/// convert many hsv colors to rgb, bit-identical to hsv2ccc3, @see ccc32hsv
+	static void hsv2ccc3(const ccColorHSV* src, ccColor3B* dst, size_t count);
+	
+	/**
+	 * shift hue and adjust saturation and value of many colors in place. For every color,
+	 * hue is rotated by dh degrees, ds and dv are added to saturation and value and clamped
+	 * to [0, 1]. It is vectorized like ccc32hsv batch version
+	 *
+	 * @param colors colors to be adjusted
+	 * @param count color count
+	 * @param dh hue offset in degree, can be negative
+	 * @param ds saturation offset
+	 * @param dv value offset
+	 */
+	static void adjustHSV(ccColor3B* colors, size_t count, float dh, float ds, float dv);
+	
+	/// adjust hsv of many rgba colors in place, alpha is not changed, @see adjustHSV
+	static void adjustHSV(ccColor4B* colors, size_t count, float dh, float ds, float dv);
+	
+	/**
+	 * adjust hsv of a RGBA8888 pixel buffer in place, alpha is not changed. It can be used
+	 * to shift hue of image data before creating texture, @see adjustHSV
+	 *
+	 * @param pixels pixel buffer, 4 bytes per pixel
+	 * @param count pixel count
+	 */
+	static void adjustHSVRGBA8(unsigned char* pixels, size_t count, float dh, float ds, float dv);
+	
 	/// get node origin, relative to parent space
 	static CCPoint getOrigin(CCNode* node);
 	
@@ -221,13 +431,24 @@ public:
 	// get node point, in node space
 	static CCPoint getLocalPoint(CCNode* node, CCPoint anchor);
 	
-	/// change opacity recursively
+	/**
+	 * change opacity recursively. It walks and casts every node in each call,
+	 * use \c CCNodeIndex if you change opacity of a big tree frequently
+	 */
 	static void setTreeOpacity(CCNode* n, int o);
 	
-	/// is a segment intersected with a box
+	/// is a segment intersected with a box, use \c CCAABBSet to test many segments and boxes
 	static bool testSegmentAABB(CCPoint p0, CCPoint p1, ccAABB b);
 	
-	/// perform a binary search in a int array
+	/**
+	 * perform a binary search in a int array
+	 *
+	 * @param a sorted array
+	 * @param len length of array
+	 * @param key key to search
+	 * @return index of key, or -(insertion point + 1) if not found. If array is searched
+	 * 		frequently, build a \c CCSearchIndex once and use it instead
+	 */
 	static int binarySearch(int* a, size_t len, int key);
     
     /// combine two rect
@@ -236,7 +457,7 @@ public:
     /// has external storage, such as sd card
     static bool hasExternalStorage();
     
-    /// current time milliseconds from 1970-1-1
+    /// current time milliseconds from 1970-1-1, it is wall clock so use \c CCClock to measure interval
     static int64_t currentTimeMillis();
     
     /// verify app signature, if has, basically it is only used for android
@@ -247,6 +468,10 @@ public:
      * returned string list is const and no need to release
      * the list is shared, you must copy its content if you want to keep content for later use
      *
+     * \note
+     * The returned list is shared so it is not thread safe, use \c ComponentIterator in 
+     * other threads
+     *
      * @param s string
      * @param sep separator character
      * @return a const vector, must copy it if you want to keep its content
@@ -306,6 +531,41 @@ public:
      */
     static CCRect ccrFromString(const string& s);
     
+    /**
+     * parse many points from a buffer in one pass, for example "{1,2} {3,4}, [5,6]".
+     * Every literal starts with brace, bracket or parentheses and its content follows
+     * same tolerance as ccpFromString. Anything between literals is skipped. A literal
+     * without closing brace ends at next opening brace or end of buffer.
+     *
+     * @param s buffer, not need to be null terminated
+     * @param len buffer length
+     * @param out array to hold parsed points
+     * @param max capacity of out array
+     * @return count of points parsed, at most max
+     */
+    static size_t ccpArrayFromString(const char* s, size_t len, CCPoint* out, size_t max);
+    
+    /// parse many sizes from a buffer in one pass, @see ccpArrayFromString
+    static size_t ccsArrayFromString(const char* s, size_t len, CCSize* out, size_t max);
+    
+    /// parse many rects from a buffer in one pass, @see ccpArrayFromString
+    static size_t ccrArrayFromString(const char* s, size_t len, CCRect* out, size_t max);
+    
+    /**
+     * parse a decimal floating number, it is faster than atof and doesn't depend on
+     * C locale, so '.' is always the decimal point. Leading white space, sign and exponent
+     * are accepted. Result is always correctly rounded. When there are at most 15 significant
+     * digits and decimal exponent is between -22 and 22, it is computed by one exact multiply
+     * or divide, other numbers are rare in game data and are passed to strtod so they are
+     * slower. hex float, inf and nan are not supported
+     *
+     * @param s string, not need to be null terminated
+     * @param len max length to parse
+     * @param used if not NULL, return count of characters consumed, 0 means no number is found
+     * @return parsed number, or 0 if no number is found
+     */
+    static double parseDouble(const char* s, size_t len, size_t* used = NULL);
+    
     /**
      * create a CCArray from a string in format {a1,a2,a3,...}. If the element is
      * embraced by quote or double quote, it will be a CCString object.
@@ -320,12 +580,51 @@ public:
      * convert CCArray to string format, rule is same as arrayFromString
      */
     static string arrayToString(const CCArray& array);
+    
+    /**
+     * parse a string into a typed value array, rule is same as arrayFromString but
+     * no CCObject is created. Number is saved as FLOAT and quoted string is saved as STRING
+     *
+     * @param s string
+     * @param out array to save values, it is cleared first
+     * @return out
+     */
+    static ValueArray& arrayFromString(const string& s, ValueArray& out);
+    
+    /// parse a buffer into a typed value array, buffer is not need to be null terminated
+    static ValueArray& arrayFromString(const char* s, size_t len, ValueArray& out);
+    
+    /**
+     * convert typed value array to string format, rule is same as arrayFromString.
+     * Number is written in shortest form which can be parsed back to same value,
+     * and decimal point is always '.'
+     *
+     * @param values value array
+     * @param out buffer to save result, it is cleared first so it can be reused
+     * @return out
+     */
+    static string& arrayToString(const ValueArray& values, string& out);
+    
+    /**
+     * format a float in shortest form which can be parsed back to same value by
+     * \c parseDouble, decimal point is always '.'. Most values need one sprintf,
+     * values which need 7 to 9 significant digits need more
+     *
+     * @param f float
+     * @param buf buffer, 32 bytes is enough
+     * @return length of formatted string
+     */
+    static int formatFloat(float f, char* buf);
+    
+    /// format a double in shortest form which can be parsed back to same value, @see formatFloat
+    static int formatDouble(double d, char* buf);
 	
-	/// set opacity from a node, to all its descentants
+	/// set opacity from a node, to all its descentants, @see setTreeOpacity
 	static void setOpacityRecursively(CCNode* node, int o);
     
     /**
-     * get CPU freqency, in Hz
+     * get CPU freqency, in Hz. For core count, cluster layout and SIMD features,
+     * use \c CCCpuInfo
      *
      * @return freqency. However, for iOS, it returns a fake and approximate value
      *      It will returns 0 if it can't be queried
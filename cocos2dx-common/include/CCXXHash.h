@@ -0,0 +1,117 @@
+/****************************************************************************
+ Author: Luma (stubma@gmail.com)
+ 
+ https://github.com/stubma/cocos2dx-common
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ ****************************************************************************/
+#ifndef __CCXXHash_h__
+#define __CCXXHash_h__
+
+#include "cocos2d.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+
+using namespace std;
+
+/// xxhash64 context, used by incremental api
+typedef struct ccXXH64Context {
+	/// total length fed
+	uint64_t totalLen;
+	
+	/// four accumulators
+	uint64_t v[4];
+	
+	/// seed
+	uint64_t seed;
+	
+	/// buffered input, less than a 32 bytes stripe
+	unsigned char mem[32];
+	
+	/// length of buffered input
+	uint32_t memSize;
+} ccXXH64Context;
+
+/**
+ * xxHash64, a fast non-cryptographic 64 bits hash. It is many times faster than
+ * md5 and suitable for cache keys or deduplication, but never use it for security.
+ * Input is always read in little endian order so the result is same on all platforms
+ */
+class CC_DLL CCXXHash {
+public:
+	/**
+	 * calculate 64 bits hash for a binary data
+	 *
+	 * @param data binary data
+	 * @param len data length
+	 * @param seed hash seed, different seeds give unrelated results
+	 * @return 64 bits hash
+	 */
+	static uint64_t hash64(const void* data, size_t len, uint64_t seed = 0);
+	
+	/**
+	 * calculate 64 bits hash for a C string, terminator is not included. It has
+	 * a different name so that hash64(buf, len) of a char buffer never picks it
+	 *
+	 * @param s C string
+	 * @param seed hash seed
+	 * @return 64 bits hash
+	 */
+	static uint64_t hash64String(const char* s, uint64_t seed = 0);
+	
+	/// calculate 64 bits hash for a string, same as hash64(s.data(), s.length(), seed)
+	static uint64_t hash64String(const string& s, uint64_t seed = 0);
+	
+	/**
+	 * initialize a hash context, must be called before update
+	 *
+	 * @param context hash context
+	 * @param seed hash seed
+	 */
+	static void init(ccXXH64Context* context, uint64_t seed = 0);
+	
+	/**
+	 * feed a block of data into hash context, it can be called many times
+	 *
+	 * @param context hash context
+	 * @param data binary data
+	 * @param len data length
+	 */
+	static void update(ccXXH64Context* context, const void* data, size_t len);
+	
+	/**
+	 * get hash of all data fed. It doesn't change context so more data can
+	 * still be fed after it
+	 *
+	 * @param context hash context
+	 * @return 64 bits hash
+	 */
+	static uint64_t final(const ccXXH64Context* context);
+	
+	/**
+	 * convert a 64 bits hash to 16 hex characters, without allocation
+	 *
+	 * @param h hash value
+	 * @param hex buffer to hold 16 hex characters and null terminator
+	 */
+	static void toHex(uint64_t h, char hex[17]);
+};
+
+#endif // __CCXXHash_h__
@@ -27,7 +27,16 @@
 #include "CCMoreMacros.h"
 #include "ccMoreTypes.h"
 #include "CCUtils.h"
+#include "CCAABBSet.h"
+#include "CCSearchIndex.h"
+#include "CCStringTable.h"
+#include "CCPath.h"
+#include "CCClock.h"
+#include "CCCpuInfo.h"
 #include "CCMD5.h"
+#include "CCMD5Verifier.h"
+#include "CCMD5VerifierListener.h"
+#include "CCXXHash.h"
 #include "CCScroller.h"
 #include "CCScrollView.h"
 #include "CCAutoRenderMenuItemSprite.h"
@@ -43,9 +52,11 @@
 #include "CCTiledSprite.h"
 #include "CCTreeFadeIn.h"
 #include "CCTreeFadeOut.h"
+#include "CCNodeIndex.h"
 #include "CCLocalization.h"
 #include "CCRichLabelTTF.h"
 #include "CCLocale.h"
+#include "CCLocaleListener.h"
 #include "CCCalendar.h"
 #include "CCVelocityTracker.h"
 #include "CCToast.h"
@@ -16,6 +16,12 @@ public class SystemUtils {
 	public static final String MEMTOTAL_PATTERN = "MemTotal[\\s]*:[\\s]*(\\d+)[\\s]*kB\n";
 	public static final String MEMFREE_PATTERN = "MemFree[\\s]*:[\\s]*(\\d+)[\\s]*kB\n";
 
+	/**
+	 * Refresh cached locale in native side, it must be called in GL thread when
+	 * activity receives a configuration change of locale.
+	 */
+	public static native void nativeOnLocaleChanged();
+
 	/**
 	 * @return in kiloHertz.
 	 * @throws SystemUtilsException
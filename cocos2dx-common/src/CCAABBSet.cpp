@@ -0,0 +1,436 @@
+/****************************************************************************
+ Author: Luma (stubma@gmail.com)
+ 
+ https://github.com/stubma/cocos2dx-common
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ ****************************************************************************/
+#include "CCAABBSet.h"
+#include <float.h>
+#include <math.h>
+#include <algorithm>
+
+/*
+Four boxes are tested in parallel lanes with same separating axis test as
+CCUtils::testSegmentAABB. A lane mask is returned, bit i set means box i hits
+*/
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#include <emmintrin.h>
+	#define AABB_LANES 4
+	typedef __m128 VFLOAT4;
+	#define VF_LOAD(p) _mm_loadu_ps(p)
+	#define VF_SET1(x) _mm_set1_ps(x)
+	#define VF_ADD(a, b) _mm_add_ps((a), (b))
+	#define VF_SUB(a, b) _mm_sub_ps((a), (b))
+	#define VF_MUL(a, b) _mm_mul_ps((a), (b))
+	#define VF_ABS(a) _mm_and_ps((a), _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff)))
+	#define VF_GT(a, b) _mm_cmpgt_ps((a), (b))
+	#define VF_OR(a, b) _mm_or_ps((a), (b))
+	#define VF_MASK(m) _mm_movemask_ps(m)
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+	#include <arm_neon.h>
+	#define AABB_LANES 4
+	typedef float32x4_t VFLOAT4;
+	#define VF_LOAD(p) vld1q_f32(p)
+	#define VF_SET1(x) vdupq_n_f32(x)
+	#define VF_ADD(a, b) vaddq_f32((a), (b))
+	#define VF_SUB(a, b) vsubq_f32((a), (b))
+	#define VF_MUL(a, b) vmulq_f32((a), (b))
+	#define VF_ABS(a) vabsq_f32(a)
+	#define VF_GT(a, b) vreinterpretq_f32_u32(vcgtq_f32((a), (b)))
+	#define VF_OR(a, b) vreinterpretq_f32_u32(vorrq_u32(vreinterpretq_u32_f32(a), vreinterpretq_u32_f32(b)))
+	static inline int VF_MASK(float32x4_t m) {
+		uint32_t bits[4];
+		vst1q_u32(bits, vreinterpretq_u32_f32(m));
+		return (bits[0] & 1) | (bits[1] & 2) | (bits[2] & 4) | (bits[3] & 8);
+	}
+#endif
+
+NS_CC_BEGIN
+
+/// segment in form of midpoint and half vector
+typedef struct ccSegmentParams {
+	float mx, my;
+	float dx, dy;
+	float adx, ady;
+} ccSegmentParams;
+
+static inline ccSegmentParams makeSegmentParams(const CCPoint& p0, const CCPoint& p1) {
+	CCPoint m = ccpMult(ccpAdd(p0, p1), 0.5f);
+	CCPoint d = ccpSub(p1, m);
+	ccSegmentParams s = {
+		m.x, m.y,
+		d.x, d.y,
+		fabsf(d.x), fabsf(d.y)
+	};
+	return s;
+}
+
+/// test a segment against four boxes, returns hit mask of lanes
+static inline int testSegment4(const ccSegmentParams& s, const float* cx, const float* cy, const float* ex, const float* ey) {
+#ifdef AABB_LANES
+	VFLOAT4 vex = VF_LOAD(ex);
+	VFLOAT4 vey = VF_LOAD(ey);
+	VFLOAT4 mx = VF_SUB(VF_SET1(s.mx), VF_LOAD(cx));
+	VFLOAT4 my = VF_SUB(VF_SET1(s.my), VF_LOAD(cy));
+	VFLOAT4 miss = VF_GT(VF_ABS(mx), VF_ADD(vex, VF_SET1(s.adx)));
+	miss = VF_OR(miss, VF_GT(VF_ABS(my), VF_ADD(vey, VF_SET1(s.ady))));
+	VFLOAT4 cross = VF_SUB(VF_MUL(mx, VF_SET1(s.dy)), VF_MUL(my, VF_SET1(s.dx)));
+	VFLOAT4 limit = VF_ADD(VF_MUL(vex, VF_SET1(s.ady + FLT_EPSILON)), VF_MUL(vey, VF_SET1(s.adx + FLT_EPSILON)));
+	miss = VF_OR(miss, VF_GT(VF_ABS(cross), limit));
+	return ~VF_MASK(miss) & 0xf;
+#else
+	int mask = 0;
+	for(int i = 0; i < 4; i++) {
+		float mx = s.mx - cx[i];
+		float my = s.my - cy[i];
+		if(fabsf(mx) > ex[i] + s.adx)
+			continue;
+		if(fabsf(my) > ey[i] + s.ady)
+			continue;
+		if(fabsf(mx * s.dy - my * s.dx) > ex[i] * (s.ady + FLT_EPSILON) + ey[i] * (s.adx + FLT_EPSILON))
+			continue;
+		mask |= 1 << i;
+	}
+	return mask;
+#endif
+}
+
+/// fraction of segment where it enters a box, it is clamped to [0, 1]
+static float segmentEntryFraction(const CCPoint& p0, const CCPoint& p1, const ccAABB& b) {
+	float tmin = 0;
+	float d[2] = { p1.x - p0.x, p1.y - p0.y };
+	float p[2] = { p0.x, p0.y };
+	float min[2] = { b.min.x, b.min.y };
+	float max[2] = { b.max.x, b.max.y };
+	for(int i = 0; i < 2; i++) {
+		if(d[i] != 0) {
+			float t1 = (min[i] - p[i]) / d[i];
+			float t2 = (max[i] - p[i]) / d[i];
+			tmin = MAX(tmin, MIN(t1, t2));
+		}
+	}
+	return MIN(tmin, 1.0f);
+}
+
+/// collect all hits
+struct CCAABBHitCollector {
+	vector<CCAABBSet::Hit>* hits;
+	int segment;
+	
+	void operator()(int box) {
+		CCAABBSet::Hit h = { segment, box };
+		hits->push_back(h);
+	}
+};
+
+/// find first hit
+struct CCAABBFirstHitFinder {
+	const CCAABBSet* set;
+	CCPoint p0;
+	CCPoint p1;
+	int box;
+	float fraction;
+	
+	void operator()(int b) {
+		float f = segmentEntryFraction(p0, p1, set->getBoxAt(b));
+		if(box == -1 || f < fraction) {
+			box = b;
+			fraction = f;
+		}
+	}
+};
+
+CCAABBSet::CCAABBSet() :
+		m_hasGrid(false),
+		m_gridX(0),
+		m_gridY(0),
+		m_cellSize(0),
+		m_cols(0),
+		m_rows(0),
+		m_stamp(0) {
+}
+
+void CCAABBSet::clear() {
+	m_boxes.clear();
+	updateArrays();
+	clearGrid();
+}
+
+void CCAABBSet::setBoxes(const ccAABB* boxes, size_t count) {
+	m_boxes.assign(boxes, boxes + count);
+	updateArrays();
+	clearGrid();
+}
+
+void CCAABBSet::addBox(const ccAABB& box) {
+	m_boxes.push_back(box);
+	updateArrays();
+	clearGrid();
+}
+
+void CCAABBSet::updateArrays() {
+	// pad to multiple of 4, padding lanes are masked when testing
+	size_t count = m_boxes.size();
+	size_t padded = (count + 3) & ~(size_t)3;
+	m_cx.resize(padded);
+	m_cy.resize(padded);
+	m_ex.resize(padded);
+	m_ey.resize(padded);
+	for(size_t i = 0; i < count; i++) {
+		const ccAABB& b = m_boxes[i];
+		CCPoint c = ccpMult(ccpAdd(b.min, b.max), 0.5f);
+		CCPoint e = ccpSub(b.max, c);
+		m_cx[i] = c.x;
+		m_cy[i] = c.y;
+		m_ex[i] = e.x;
+		m_ey[i] = e.y;
+	}
+	for(size_t i = count; i < padded; i++) {
+		m_cx[i] = m_cy[i] = m_ex[i] = m_ey[i] = 0;
+	}
+	m_stamps.assign(count, 0);
+	m_stamp = 0;
+}
+
+void CCAABBSet::clearGrid() {
+	m_hasGrid = false;
+	m_cols = m_rows = 0;
+	m_cellStart.clear();
+	m_cellBoxes.clear();
+}
+
+void CCAABBSet::buildGrid(float cellSize) {
+	clearGrid();
+	size_t count = m_boxes.size();
+	if(count == 0)
+		return;
+	
+	// bounds and average size
+	float minX = FLT_MAX, minY = FLT_MAX, maxX = -FLT_MAX, maxY = -FLT_MAX;
+	double totalSize = 0;
+	for(size_t i = 0; i < count; i++) {
+		const ccAABB& b = m_boxes[i];
+		minX = MIN(minX, b.min.x);
+		minY = MIN(minY, b.min.y);
+		maxX = MAX(maxX, b.max.x);
+		maxY = MAX(maxY, b.max.y);
+		totalSize += (b.max.x - b.min.x) + (b.max.y - b.min.y);
+	}
+	if(cellSize <= 0)
+		cellSize = (float)(totalSize / count);
+	
+	// limit cell count, grid is at most 256 x 256
+	float w = maxX - minX;
+	float h = maxY - minY;
+	cellSize = MAX(cellSize, MAX(w, h) / 256);
+	if(cellSize <= 0)
+		cellSize = 1;
+	m_cellSize = cellSize;
+	m_gridX = minX;
+	m_gridY = minY;
+	m_cols = MIN(256, (int)(w / cellSize) + 1);
+	m_rows = MIN(256, (int)(h / cellSize) + 1);
+	
+	// count boxes of every cell, box is expanded a little so segment on cell border won't miss it
+	int cells = m_cols * m_rows;
+	float margin = cellSize * 1e-4f;
+	vector<int> ranges(count * 4);
+	m_cellStart.assign(cells + 1, 0);
+	for(size_t i = 0; i < count; i++) {
+		const ccAABB& b = m_boxes[i];
+		int* r = &ranges[i * 4];
+		r[0] = clampf((b.min.x - margin - minX) / cellSize, 0, m_cols - 1);
+		r[1] = clampf((b.min.y - margin - minY) / cellSize, 0, m_rows - 1);
+		r[2] = clampf((b.max.x + margin - minX) / cellSize, 0, m_cols - 1);
+		r[3] = clampf((b.max.y + margin - minY) / cellSize, 0, m_rows - 1);
+		for(int y = r[1]; y <= r[3]; y++) {
+			for(int x = r[0]; x <= r[2]; x++) {
+				m_cellStart[y * m_cols + x + 1]++;
+			}
+		}
+	}
+	
+	// fill cells, box indices are ascending in every cell
+	for(int i = 0; i < cells; i++) {
+		m_cellStart[i + 1] += m_cellStart[i];
+	}
+	m_cellBoxes.resize(m_cellStart[cells]);
+	vector<int> fill(m_cellStart.begin(), m_cellStart.end() - 1);
+	for(size_t i = 0; i < count; i++) {
+		int* r = &ranges[i * 4];
+		for(int y = r[1]; y <= r[3]; y++) {
+			for(int x = r[0]; x <= r[2]; x++) {
+				m_cellBoxes[fill[y * m_cols + x]++] = i;
+			}
+		}
+	}
+	
+	m_hasGrid = true;
+}
+
+bool CCAABBSet::collectCandidates(const CCPoint& p0, const CCPoint& p1) {
+	m_candidates.clear();
+	
+	// clip segment to grid bounds
+	float gridW = m_cols * m_cellSize;
+	float gridH = m_rows * m_cellSize;
+	float dx = p1.x - p0.x;
+	float dy = p1.y - p0.y;
+	float t0 = 0, t1 = 1;
+	float p[2] = { p0.x - m_gridX, p0.y - m_gridY };
+	float d[2] = { dx, dy };
+	float size[2] = { gridW, gridH };
+	for(int i = 0; i < 2; i++) {
+		if(d[i] == 0) {
+			if(p[i] < 0 || p[i] > size[i])
+				return false;
+		} else {
+			float ta = -p[i] / d[i];
+			float tb = (size[i] - p[i]) / d[i];
+			t0 = MAX(t0, MIN(ta, tb));
+			t1 = MIN(t1, MAX(ta, tb));
+		}
+	}
+	if(t0 > t1)
+		return false;
+	float x0 = p[0] + dx * t0;
+	float y0 = p[1] + dy * t0;
+	float x1 = p[0] + dx * t1;
+	float y1 = p[1] + dy * t1;
+	
+	// walk cells along segment
+	int ix = clampf(x0 / m_cellSize, 0, m_cols - 1);
+	int iy = clampf(y0 / m_cellSize, 0, m_rows - 1);
+	int endX = clampf(x1 / m_cellSize, 0, m_cols - 1);
+	int endY = clampf(y1 / m_cellSize, 0, m_rows - 1);
+	int stepX = dx > 0 ? 1 : (dx < 0 ? -1 : 0);
+	int stepY = dy > 0 ? 1 : (dy < 0 ? -1 : 0);
+	float tMaxX = stepX == 0 ? FLT_MAX : ((ix + (stepX > 0 ? 1 : 0)) * m_cellSize - x0) / dx;
+	float tMaxY = stepY == 0 ? FLT_MAX : ((iy + (stepY > 0 ? 1 : 0)) * m_cellSize - y0) / dy;
+	float tDeltaX = stepX == 0 ? FLT_MAX : m_cellSize / fabsf(dx);
+	float tDeltaY = stepY == 0 ? FLT_MAX : m_cellSize / fabsf(dy);
+	
+	// new stamp for this query
+	if(++m_stamp == 0) {
+		m_stamps.assign(m_stamps.size(), 0);
+		m_stamp = 1;
+	}
+	
+	int maxSteps = m_cols + m_rows + 2;
+	for(int step = 0; step < maxSteps; step++) {
+		int cell = iy * m_cols + ix;
+		for(int i = m_cellStart[cell]; i < m_cellStart[cell + 1]; i++) {
+			int box = m_cellBoxes[i];
+			if(m_stamps[box] != m_stamp) {
+				m_stamps[box] = m_stamp;
+				m_candidates.push_back(box);
+			}
+		}
+		
+		// next cell
+		if(ix == endX && iy == endY)
+			break;
+		if(tMaxX < tMaxY) {
+			ix += stepX;
+			tMaxX += tDeltaX;
+		} else {
+			iy += stepY;
+			tMaxY += tDeltaY;
+		}
+		if(ix < 0 || ix >= m_cols || iy < 0 || iy >= m_rows)
+			break;
+	}
+	
+	// keep box order same as brute force
+	sort(m_candidates.begin(), m_candidates.end());
+	return !m_candidates.empty();
+}
+
+template<typename T>
+void CCAABBSet::testSegment(const CCPoint& p0, const CCPoint& p1, T& visitor) {
+	ccSegmentParams s = makeSegmentParams(p0, p1);
+	if(m_hasGrid) {
+		if(!collectCandidates(p0, p1))
+			return;
+		
+		// gather candidates into lanes
+		float cx[4], cy[4], ex[4], ey[4];
+		size_t n = m_candidates.size();
+		for(size_t i = 0; i < n; i += 4) {
+			int lanes = MIN(4, (int)(n - i));
+			for(int j = 0; j < 4; j++) {
+				int box = m_candidates[i + MIN(j, lanes - 1)];
+				cx[j] = m_cx[box];
+				cy[j] = m_cy[box];
+				ex[j] = m_ex[box];
+				ey[j] = m_ey[box];
+			}
+			int mask = testSegment4(s, cx, cy, ex, ey) & ((1 << lanes) - 1);
+			for(int j = 0; mask; j++, mask >>= 1) {
+				if(mask & 1)
+					visitor(m_candidates[i + j]);
+			}
+		}
+	} else {
+		// all boxes, padding lanes are masked
+		size_t count = m_boxes.size();
+		for(size_t i = 0; i < count; i += 4) {
+			int mask = testSegment4(s, &m_cx[i], &m_cy[i], &m_ex[i], &m_ey[i]);
+			if(count - i < 4)
+				mask &= (1 << (count - i)) - 1;
+			for(int j = 0; mask; j++, mask >>= 1) {
+				if(mask & 1)
+					visitor((int)(i + j));
+			}
+		}
+	}
+}
+
+size_t CCAABBSet::querySegments(const CCPoint* p0, const CCPoint* p1, size_t count, vector<Hit>& hits) {
+	size_t oldSize = hits.size();
+	CCAABBHitCollector collector;
+	collector.hits = &hits;
+	for(size_t i = 0; i < count; i++) {
+		collector.segment = i;
+		testSegment(p0[i], p1[i], collector);
+	}
+	return hits.size() - oldSize;
+}
+
+size_t CCAABBSet::queryFirstHits(const CCPoint* p0, const CCPoint* p1, size_t count, int* boxes, float* fractions) {
+	size_t hitCount = 0;
+	CCAABBFirstHitFinder finder;
+	finder.set = this;
+	for(size_t i = 0; i < count; i++) {
+		finder.p0 = p0[i];
+		finder.p1 = p1[i];
+		finder.box = -1;
+		finder.fraction = 1;
+		testSegment(p0[i], p1[i], finder);
+		boxes[i] = finder.box;
+		if(fractions)
+			fractions[i] = finder.fraction;
+		if(finder.box != -1)
+			hitCount++;
+	}
+	return hitCount;
+}
+
+NS_CC_END
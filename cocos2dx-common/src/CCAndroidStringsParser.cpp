@@ -24,8 +24,350 @@
 #include "CCAndroidStringsParser.h"
 #include "CCUtils.h"
 
+/// is a XML white space
+#define IS_XML_SPACE(c) ((c) == ' ' || (c) == '\t' || (c) == '\r' || (c) == '\n')
+
 NS_CC_BEGIN
 
+/// check if p starts with a literal
+static inline bool startsWith(const char* p, const char* end, const char* s, size_t len) {
+	return (size_t)(end - p) >= len && !memcmp(p, s, len);
+}
+
+/// find a literal, returns end if not found
+static const char* findLiteral(const char* p, const char* end, const char* s, size_t len) {
+	while(p < end) {
+		const char* c = (const char*)memchr(p, s[0], end - p);
+		if(!c)
+			return end;
+		if(startsWith(c, end, s, len))
+			return c;
+		p = c + 1;
+	}
+	return end;
+}
+
+/// encode a code point in UTF-8, returns new output position
+static char* appendUTF8(char* out, unsigned int cp) {
+	if(cp < 0x80) {
+		*out++ = (char)cp;
+	} else if(cp < 0x800) {
+		*out++ = (char)(0xc0 | (cp >> 6));
+		*out++ = (char)(0x80 | (cp & 0x3f));
+	} else if(cp < 0x10000) {
+		*out++ = (char)(0xe0 | (cp >> 12));
+		*out++ = (char)(0x80 | ((cp >> 6) & 0x3f));
+		*out++ = (char)(0x80 | (cp & 0x3f));
+	} else if(cp < 0x110000) {
+		*out++ = (char)(0xf0 | (cp >> 18));
+		*out++ = (char)(0x80 | ((cp >> 12) & 0x3f));
+		*out++ = (char)(0x80 | ((cp >> 6) & 0x3f));
+		*out++ = (char)(0x80 | (cp & 0x3f));
+	}
+	return out;
+}
+
+/// parse hex digits, returns digit count
+static int parseHex(const char* p, const char* end, int maxDigits, unsigned int* value) {
+	int n = 0;
+	*value = 0;
+	while(p < end && n < maxDigits) {
+		char c = *p++;
+		int d;
+		if(c >= '0' && c <= '9')
+			d = c - '0';
+		else if(c >= 'a' && c <= 'f')
+			d = c - 'a' + 10;
+		else if(c >= 'A' && c <= 'F')
+			d = c - 'A' + 10;
+		else
+			break;
+		*value = (*value << 4) | d;
+		n++;
+	}
+	return n;
+}
+
+/**
+ * decode an entity at p, which points to '&'. Output is never longer than input
+ * so it can be decoded in place. Unknown entity is copied as is.
+ */
+static char* decodeEntity(const char*& p, const char* end, char* out) {
+	const char* semicolon = (const char*)memchr(p, ';', MIN(end - p, 12));
+	if(semicolon) {
+		const char* name = p + 1;
+		size_t len = semicolon - name;
+		char c = 0;
+		if(len == 2 && !memcmp(name, "lt", 2))
+			c = '<';
+		else if(len == 2 && !memcmp(name, "gt", 2))
+			c = '>';
+		else if(len == 3 && !memcmp(name, "amp", 3))
+			c = '&';
+		else if(len == 4 && !memcmp(name, "quot", 4))
+			c = '"';
+		else if(len == 4 && !memcmp(name, "apos", 4))
+			c = '\'';
+		if(c) {
+			*out++ = c;
+			p = semicolon + 1;
+			return out;
+		}
+		
+		// numeric character reference
+		if(len > 1 && name[0] == '#') {
+			unsigned int cp = 0;
+			bool valid;
+			if(name[1] == 'x' || name[1] == 'X') {
+				valid = len > 2 && parseHex(name + 2, semicolon, 8, &cp) == (int)len - 2;
+			} else {
+				valid = true;
+				for(const char* d = name + 1; d < semicolon && valid; d++) {
+					valid = *d >= '0' && *d <= '9';
+					cp = cp * 10 + (*d - '0');
+				}
+			}
+			if(valid && cp < 0x110000) {
+				p = semicolon + 1;
+				return appendUTF8(out, cp);
+			}
+		}
+	}
+	
+	*out++ = *p++;
+	return out;
+}
+
+/**
+ * decode an Android backslash escape at p, which points to '\'. Output is never
+ * longer than input
+ */
+static char* decodeEscape(const char*& p, const char* end, char* out) {
+	if(p + 1 >= end) {
+		*out++ = *p++;
+		return out;
+	}
+	char c = p[1];
+	p += 2;
+	switch(c) {
+		case 'n':
+			*out++ = '\n';
+			break;
+		case 't':
+			*out++ = '\t';
+			break;
+		case 'u':
+		{
+			unsigned int cp;
+			int n = parseHex(p, end, 4, &cp);
+			if(n == 4) {
+				p += 4;
+				
+				// surrogate pair is one code point, lone surrogate is not valid in utf-8
+				if(cp >= 0xd800 && cp <= 0xdbff) {
+					unsigned int low;
+					if(p + 1 < end && p[0] == '\\' && p[1] == 'u' && parseHex(p + 2, end, 4, &low) == 4 &&
+					   low >= 0xdc00 && low <= 0xdfff) {
+						p += 6;
+						cp = 0x10000 + ((cp - 0xd800) << 10) + (low - 0xdc00);
+					} else {
+						cp = 0xfffd;
+					}
+				} else if(cp >= 0xdc00 && cp <= 0xdfff) {
+					cp = 0xfffd;
+				}
+				out = appendUTF8(out, cp);
+			} else {
+				*out++ = 'u';
+			}
+			break;
+		}
+		default:
+			// \' \" \\ \@ \? and others, just drop backslash
+			*out++ = c;
+			break;
+	}
+	return out;
+}
+
+/// skip to end of a tag, returns position after '>'
+static const char* skipTag(const char* p, const char* end) {
+	char quote = 0;
+	for(; p < end; p++) {
+		if(quote) {
+			if(*p == quote)
+				quote = 0;
+		} else if(*p == '"' || *p == '\'') {
+			quote = *p;
+		} else if(*p == '>') {
+			return p + 1;
+		}
+	}
+	return end;
+}
+
+/**
+ * parse attributes of an element, find value of an attribute and decode it in place.
+ * p points to first char after element name
+ *
+ * @return position after '>', or end if tag is broken
+ */
+static const char* parseTag(const char* p, const char* end, const char* attr, size_t attrLength,
+							char** key, size_t* keyLength, bool* empty) {
+	*key = NULL;
+	*keyLength = 0;
+	*empty = false;
+	while(p < end) {
+		// skip white spaces
+		while(p < end && IS_XML_SPACE(*p))
+			p++;
+		if(p >= end)
+			break;
+		
+		// end of tag
+		if(*p == '>')
+			return p + 1;
+		if(*p == '/' && p + 1 < end && p[1] == '>') {
+			*empty = true;
+			return p + 2;
+		}
+		
+		// attribute name
+		const char* name = p;
+		while(p < end && *p != '=' && *p != '>' && *p != '/' && !IS_XML_SPACE(*p))
+			p++;
+		size_t nameLength = p - name;
+		if(nameLength == 0) {
+			// junk such as '/' not followed by '>' or '=' without name, skip it
+			p++;
+			continue;
+		}
+		while(p < end && IS_XML_SPACE(*p))
+			p++;
+		if(p >= end || *p != '=') {
+			continue;
+		}
+		p++;
+		while(p < end && IS_XML_SPACE(*p))
+			p++;
+		if(p >= end || (*p != '"' && *p != '\''))
+			break;
+		
+		// attribute value
+		char quote = *p++;
+		const char* value = p;
+		const char* valueEnd = (const char*)memchr(p, quote, end - p);
+		if(!valueEnd)
+			break;
+		p = valueEnd + 1;
+		if(nameLength == attrLength && !memcmp(name, attr, attrLength)) {
+			char* out = (char*)value;
+			*key = out;
+			const char* v = value;
+			while(v < valueEnd) {
+				if(*v == '&')
+					out = decodeEntity(v, valueEnd, out);
+				else
+					*out++ = *v++;
+			}
+			*keyLength = out - *key;
+		}
+	}
+	return end;
+}
+
+/**
+ * parse content of an element and decode it in place, p points to first char
+ * after start tag
+ *
+ * @param endTag end tag without '>', such as "</string"
+ * @return position after end tag
+ */
+static const char* parseContent(const char* p, const char* end, const char* endTag, size_t endTagLength,
+								char** value, size_t* valueLength) {
+	char* out = (char*)p;
+	*value = out;
+	while(p < end) {
+		char c = *p;
+		if(c == '<') {
+			if(startsWith(p, end, endTag, endTagLength)) {
+				*valueLength = out - *value;
+				return skipTag(p, end);
+			} else if(startsWith(p, end, "<![CDATA[", 9)) {
+				// copy raw characters
+				const char* cdataEnd = findLiteral(p + 9, end, "]]>", 3);
+				size_t len = cdataEnd - (p + 9);
+				memmove(out, p + 9, len);
+				out += len;
+				p = MIN(cdataEnd + 3, end);
+			} else if(startsWith(p, end, "<!--", 4)) {
+				p = MIN(findLiteral(p + 4, end, "-->", 3) + 3, end);
+			} else {
+				// markup in string, drop tag and keep text
+				p = skipTag(p, end);
+			}
+		} else if(c == '&') {
+			out = decodeEntity(p, end, out);
+		} else if(c == '\\') {
+			out = decodeEscape(p, end, out);
+		} else {
+			*out++ = c;
+			p++;
+		}
+	}
+	*valueLength = out - *value;
+	return end;
+}
+
+/**
+ * parse a plurals element, every item is added with key name#quantity, such as
+ * apples#one. p points to first char after element name
+ *
+ * @return position after end tag
+ */
+static const char* parsePlurals(const char* p, const char* end, CCStringTable::Builder& builder) {
+	char* name;
+	size_t nameLength;
+	bool empty;
+	p = parseTag(p, end, "name", 4, &name, &nameLength, &empty);
+	if(empty)
+		return p;
+	
+	// items
+	string key;
+	while(p < end) {
+		p = (const char*)memchr(p, '<', end - p);
+		if(!p)
+			return end;
+		
+		if(startsWith(p, end, "</plurals", 9)) {
+			return skipTag(p, end);
+		} else if(startsWith(p, end, "<!--", 4)) {
+			p = MIN(findLiteral(p + 4, end, "-->", 3) + 3, end);
+		} else if(startsWith(p, end, "<item", 5) && p + 5 < end && IS_XML_SPACE(p[5])) {
+			char* quantity;
+			char* value;
+			size_t quantityLength, valueLength;
+			p = parseTag(p + 5, end, "quantity", 8, &quantity, &quantityLength, &empty);
+			if(empty) {
+				valueLength = 0;
+				value = (char*)"";
+			} else {
+				p = parseContent(p, end, "</item", 6, &value, &valueLength);
+			}
+			if(name && quantity) {
+				key.assign(name, nameLength);
+				key.append(1, '#');
+				key.append(quantity, quantityLength);
+				builder.add(key.c_str(), key.length(), value, valueLength);
+			}
+		} else {
+			p = skipTag(p, end);
+		}
+	}
+	return end;
+}
+
 CCAndroidStringsParser::CCAndroidStringsParser() {
 }
 
@@ -37,35 +379,68 @@ CCAndroidStringsParser* CCAndroidStringsParser::create() {
     return (CCAndroidStringsParser*)p->autorelease();
 }
 
-void CCAndroidStringsParser::parse(const string& path, const CCDictionary& dict) {
+bool CCAndroidStringsParser::parse(const string& path, CCStringTable::Builder& builder) {
     // map file path
     string localPath = CCUtils::mapLocalPath(path);
     
-    // get xml string, because tinyxml can't read file in apk
+    // get xml string, because file may be in apk
     unsigned long size;
     unsigned char* data = CCFileUtils::sharedFileUtils()->getFileData(localPath.c_str(), "rb", &size);
-    
-    // load file, if success, visit it
-    XMLDocument* doc = new XMLDocument();
-    if(doc->Parse((const char*)data, size) == XML_NO_ERROR) {
-        m_dict = (CCDictionary*)&dict;
-        doc->Accept(this);
+    if(!data) {
+        CCLOGWARN("CCAndroidStringsParser::parse: can't read %s", path.c_str());
+        return false;
     }
     
-    // release
+    // parse and release
+    bool ok = parseData((char*)data, size, builder);
     free(data);
-    delete doc;
+    return ok;
 }
 
-bool CCAndroidStringsParser::VisitEnter(const XMLElement& element, const XMLAttribute* firstAttribute) {
-    if(!strcmp(element.Name(), "string")) {
-        CCString* s = CCString::create(element.GetText());
-        const char* key = element.Attribute("name");
-        if(key) {
-            m_dict->setObject(s, key);
+bool CCAndroidStringsParser::parseData(char* data, size_t length, CCStringTable::Builder& builder) {
+    const char* p = data;
+    const char* end = data + length;
+    bool hasResources = false;
+    while(p < end) {
+        // find next tag
+        p = (const char*)memchr(p, '<', end - p);
+        if(!p)
+            break;
+        
+        if(startsWith(p, end, "<!--", 4)) {
+            p = MIN(findLiteral(p + 4, end, "-->", 3) + 3, end);
+        } else if(startsWith(p, end, "<![CDATA[", 9)) {
+            p = MIN(findLiteral(p + 9, end, "]]>", 3) + 3, end);
+        } else if(p + 1 < end && (p[1] == '?' || p[1] == '!' || p[1] == '/')) {
+            p = skipTag(p, end);
+        } else if(startsWith(p, end, "<string", 7) && p + 7 < end &&
+                  (IS_XML_SPACE(p[7]) || p[7] == '>' || p[7] == '/')) {
+            char* key;
+            char* value;
+            size_t keyLength, valueLength;
+            bool empty;
+            p = parseTag(p + 7, end, "name", 4, &key, &keyLength, &empty);
+            if(empty) {
+                valueLength = 0;
+                value = (char*)"";
+            } else {
+                p = parseContent(p, end, "</string", 8, &value, &valueLength);
+            }
+            if(key) {
+                builder.add(key, keyLength, value, valueLength);
+            }
+        } else if(startsWith(p, end, "<plurals", 8) && p + 8 < end && IS_XML_SPACE(p[8])) {
+            p = parsePlurals(p + 8, end, builder);
+        } else {
+            hasResources = hasResources || startsWith(p, end, "<resources", 10);
+            p = skipTag(p, end);
         }
     }
-    return true;
+    
+    if(!hasResources) {
+        CCLOGWARN("CCAndroidStringsParser::parseData: no resources element, it is not a strings xml");
+    }
+    return hasResources;
 }
 
-NS_CC_END
\ No newline at end of file
+NS_CC_END
@@ -25,19 +25,22 @@
 #define __CCAndroidStringsParser_h__
 
 #include "cocos2d.h"
-#include "tinyxml2.h"
+#include "CCStringTable.h"
 
-using namespace tinyxml2;
 using namespace std;
 
 NS_CC_BEGIN
 
-/// a parser of Android strings.xml, and save string key-values to a dictionary
-class CCAndroidStringsParser : public CCObject, public XMLVisitor {
-private:
-    /// hold dictionary
-    CCDictionary* m_dict;
-    
+/**
+ * a parser of Android strings.xml, and save string key-values to a string table builder.
+ * It is a single pass tokenizer for strings.xml subset, no DOM is built. Entities, CDATA and
+ * Android backslash escapes are decoded in place, so no extra memory is allocated except
+ * file data. Markup inside a string, such as &lt;b&gt;, is dropped and its text is kept.
+ *
+ * \par
+ * Items of plurals element are added with key name#quantity, such as apples#one.
+ */
+class CCAndroidStringsParser : public CCObject {
 public:
     CCAndroidStringsParser();
     virtual ~CCAndroidStringsParser();
@@ -48,17 +51,25 @@ public:
     static CCAndroidStringsParser* create();
     
     /**
-     * Parse android string XML and save strings into a dictionary
+     * Parse android string XML and add strings into a builder
      *
      * @param path string XML file path. The path is platform-independent and
      *      it will be mapped to platform format. For example, "/sdcard/strings.xml" will
      *      be mapped to "~/Documents/sdcard/strings.xml" in iOS like system.
-     * @param dict the dictionary to hold parsed strings
+     * @param builder the builder to hold parsed strings, existing keys are replaced
+     * @return true if file is parsed
      */
-    void parse(const string& path, const CCDictionary& dict);
+    bool parse(const string& path, CCStringTable::Builder& builder);
     
-    /// override XMLVisitor
-    virtual bool VisitEnter(const XMLElement& element, const XMLAttribute* firstAttribute);
+    /**
+     * Parse android string XML in memory and add strings into a builder
+     *
+     * @param data XML data, it is modified because strings are decoded in place
+     * @param length length of data
+     * @param builder the builder to hold parsed strings, existing keys are replaced
+     * @return true if data is parsed
+     */
+    bool parseData(char* data, size_t length, CCStringTable::Builder& builder);
 };
 
 NS_CC_END
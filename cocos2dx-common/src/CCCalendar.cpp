@@ -23,75 +23,29 @@
  ****************************************************************************/
 #include "CCCalendar.h"
 #include "CCUtils.h"
+#include <time.h>
 #if CC_TARGET_PLATFORM == CC_PLATFORM_IOS || CC_TARGET_PLATFORM == CC_PLATFORM_MAC
     #import <Foundation/Foundation.h>
-#elif CC_TARGET_PLATFORM == CC_PLATFORM_ANDROID
-    #include "JniHelper.h"
 #endif
 
+// length of timezone offset cache window, in seconds
+#define OFFSET_WINDOW 900
+
 NS_CC_BEGIN
 
 CCCalendar* CCCalendar::s_instance = NULL;
 
-#if CC_TARGET_PLATFORM == CC_PLATFORM_ANDROID
-
-static int DAY_OF_MONTH;
-static int DAY_OF_WEEK;
-static int MONTH;
-static int YEAR;
-static int HOUR_OF_DAY;
-static int MINUTE;
-static int SECOND;
-static jmethodID CALENDAR_GET;
-
-static void setupAndroidCalendar() {
-    // get klass of calendard
-	JNIEnv* env = CCUtils::getJNIEnv();
-    jclass klass = env->FindClass("java/util/Calendar");
-    
-    // populate field
-    jfieldID fid = env->GetStaticFieldID(klass, "DAY_OF_MONTH", "I");
-    DAY_OF_MONTH = env->GetStaticIntField(klass, fid);
-    fid = env->GetStaticFieldID(klass, "DAY_OF_WEEK", "I");
-    DAY_OF_WEEK = env->GetStaticIntField(klass, fid);
-    fid = env->GetStaticFieldID(klass, "MONTH", "I");
-    MONTH = env->GetStaticIntField(klass, fid);
-    fid = env->GetStaticFieldID(klass, "YEAR", "I");
-    YEAR = env->GetStaticIntField(klass, fid);
-    fid = env->GetStaticFieldID(klass, "HOUR_OF_DAY", "I");
-    HOUR_OF_DAY = env->GetStaticIntField(klass, fid);
-    fid = env->GetStaticFieldID(klass, "MINUTE", "I");
-    MINUTE = env->GetStaticIntField(klass, fid);
-    fid = env->GetStaticFieldID(klass, "SECOND", "I");
-    SECOND = env->GetStaticIntField(klass, fid);
-    CALENDAR_GET = env->GetMethodID(klass, "get", "(I)I");
-	
-	// clear
-	env->DeleteLocalRef(klass);
+// floor division, for time before 1970
+static int64_t floorDiv(int64_t a, int64_t b) {
+    int64_t q = a / b;
+    return (a % b != 0 && (a < 0) != (b < 0)) ? q - 1 : q;
 }
 
-static jobject createAndroidCalendar(float time) {
-    // get GregorianCalendar
-	JNIEnv* env = CCUtils::getJNIEnv();
-	jclass klass = env->FindClass("java/util/GregorianCalendar");
-    jmethodID mid = env->GetMethodID(klass, "<init>", "()V");
-    jobject jCalendar = env->NewObject(klass, mid);
-    
-    // set time
-	mid = env->GetMethodID(klass, "setTimeInMillis", "(J)V");
-    env->CallVoidMethod(jCalendar, mid, (jlong)(time * 1000.0f));
-    
-    return jCalendar;
-}
-
-#endif // #if CC_TARGET_PLATFORM == CC_PLATFORM_ANDROID
-
-CCCalendar::CCCalendar() {
-    m_time = (double)CCUtils::currentTimeMillis() / 1000.0f;
-    
-#if CC_TARGET_PLATFORM == CC_PLATFORM_ANDROID
-    setupAndroidCalendar();
-#endif
+CCCalendar::CCCalendar() :
+        m_time(0),
+        m_offset(0),
+        m_offsetWindow(-1) {
+    setNow();
 }
 
 CCCalendar::~CCCalendar() {
@@ -105,135 +59,81 @@ CCCalendar* CCCalendar::sharedCalendar() {
     return s_instance;
 }
 
-void CCCalendar::setNow() {
-    m_time = (double)CCUtils::currentTimeMillis() / 1000.0f;
-}
-
-int CCCalendar::getYear() {
-#if CC_TARGET_PLATFORM == CC_PLATFORM_IOS || CC_TARGET_PLATFORM == CC_PLATFORM_MAC
-    NSCalendar* c = [NSCalendar currentCalendar];
-    NSDate* d = [NSDate dateWithTimeIntervalSince1970:m_time];
-    NSDateComponents* dc = [c components:NSYearCalendarUnit fromDate:d];
-    return dc.year;
-#elif CC_TARGET_PLATFORM == CC_PLATFORM_ANDROID
-    jobject c = createAndroidCalendar(m_time);
-	JNIEnv* env = CCUtils::getJNIEnv();
-    int ret = env->CallIntMethod(c, CALENDAR_GET, YEAR);
-    env->DeleteLocalRef(c);
-    return ret;
-	return 0;
-#else
-    CCLOGERROR("CCCalendar::getYear is not implemented for this platform, please finish it");
-    return 0;
-#endif
-}
-
-int CCCalendar::getMonth() {
-#if CC_TARGET_PLATFORM == CC_PLATFORM_IOS || CC_TARGET_PLATFORM == CC_PLATFORM_MAC
-    NSCalendar* c = [NSCalendar currentCalendar];
-    NSDate* d = [NSDate dateWithTimeIntervalSince1970:m_time];
-    NSDateComponents* dc = [c components:NSMonthCalendarUnit fromDate:d];
-    return dc.month;
-#elif CC_TARGET_PLATFORM == CC_PLATFORM_ANDROID
-    jobject c = createAndroidCalendar(m_time);
-	JNIEnv* env = CCUtils::getJNIEnv();
-    int ret = env->CallIntMethod(c, CALENDAR_GET, MONTH) + 1;
-    env->DeleteLocalRef(c);
-    return ret;
-#else
-    CCLOGERROR("CCCalendar::getMonth is not implemented for this platform, please finish it");
-    return 0;
-#endif
+void CCCalendar::setTime(double time) {
+    setTimeMillis((int64_t)(time * 1000.0));
 }
 
-int CCCalendar::getDay() {
-#if CC_TARGET_PLATFORM == CC_PLATFORM_IOS || CC_TARGET_PLATFORM == CC_PLATFORM_MAC
-    NSCalendar* c = [NSCalendar currentCalendar];
-    NSDate* d = [NSDate dateWithTimeIntervalSince1970:m_time];
-    NSDateComponents* dc = [c components:NSDayCalendarUnit fromDate:d];
-    return dc.day;
-#elif CC_TARGET_PLATFORM == CC_PLATFORM_ANDROID
-    jobject c = createAndroidCalendar(m_time);
-	JNIEnv* env = CCUtils::getJNIEnv();
-    int ret = env->CallIntMethod(c, CALENDAR_GET, DAY_OF_MONTH);
-    env->DeleteLocalRef(c);
-    return ret;
-#else
-    CCLOGERROR("CCCalendar::getDay is not implemented for this platform, please finish it");
-    return 0;
-#endif
+void CCCalendar::setTimeMillis(int64_t time) {
+    m_time = time;
+    updateFields();
 }
 
-int CCCalendar::getWeekday() {
-#if CC_TARGET_PLATFORM == CC_PLATFORM_IOS || CC_TARGET_PLATFORM == CC_PLATFORM_MAC
-    NSCalendar* c = [NSCalendar currentCalendar];
-    NSDate* d = [NSDate dateWithTimeIntervalSince1970:m_time];
-    NSDateComponents* dc = [c components:NSWeekdayCalendarUnit fromDate:d];
-    return dc.weekday;
-#elif CC_TARGET_PLATFORM == CC_PLATFORM_ANDROID
-    jobject c = createAndroidCalendar(m_time);
-	JNIEnv* env = CCUtils::getJNIEnv();
-    int ret = env->CallIntMethod(c, CALENDAR_GET, DAY_OF_WEEK);
-    env->DeleteLocalRef(c);
-    return ret;
-#else
-    CCLOGERROR("CCCalendar::getDay is not implemented for this platform, please finish it");
-    return 0;
-#endif
+void CCCalendar::setNow() {
+    setTimeMillis(CCUtils::currentTimeMillis());
 }
 
-int CCCalendar::getHour() {
+void CCCalendar::invalidateTimeZone() {
 #if CC_TARGET_PLATFORM == CC_PLATFORM_IOS || CC_TARGET_PLATFORM == CC_PLATFORM_MAC
-    NSCalendar* c = [NSCalendar currentCalendar];
-    NSDate* d = [NSDate dateWithTimeIntervalSince1970:m_time];
-    NSDateComponents* dc = [c components:NSHourCalendarUnit fromDate:d];
-    return dc.hour;
-#elif CC_TARGET_PLATFORM == CC_PLATFORM_ANDROID
-    jobject c = createAndroidCalendar(m_time);
-	JNIEnv* env = CCUtils::getJNIEnv();
-    int ret = env->CallIntMethod(c, CALENDAR_GET, HOUR_OF_DAY);
-    env->DeleteLocalRef(c);
-    return ret;
+    [NSTimeZone resetSystemTimeZone];
+#elif CC_TARGET_PLATFORM == CC_PLATFORM_WIN32
+    _tzset();
 #else
-    CCLOGERROR("CCCalendar::getHour is not implemented for this platform, please finish it");
-    return 0;
+    tzset();
 #endif
+    m_offsetWindow = -1;
+    updateFields();
 }
 
-int CCCalendar::getMinute() {
+int CCCalendar::getOffset(int64_t seconds) {
 #if CC_TARGET_PLATFORM == CC_PLATFORM_IOS || CC_TARGET_PLATFORM == CC_PLATFORM_MAC
-    NSCalendar* c = [NSCalendar currentCalendar];
-    NSDate* d = [NSDate dateWithTimeIntervalSince1970:m_time];
-    NSDateComponents* dc = [c components:NSMinuteCalendarUnit fromDate:d];
-    return dc.minute;
-#elif CC_TARGET_PLATFORM == CC_PLATFORM_ANDROID
-    jobject c = createAndroidCalendar(m_time);
-	JNIEnv* env = CCUtils::getJNIEnv();
-    int ret = env->CallIntMethod(c, CALENDAR_GET, MINUTE);
-    env->DeleteLocalRef(c);
-    return ret;
+    NSDate* d = [NSDate dateWithTimeIntervalSince1970:(NSTimeInterval)seconds];
+    return (int)[[NSTimeZone localTimeZone] secondsFromGMTForDate:d];
+#elif CC_TARGET_PLATFORM == CC_PLATFORM_WIN32
+    __time64_t t = seconds;
+    struct tm local;
+    if(_localtime64_s(&local, &t) != 0)
+        return 0;
+    return (int)(_mkgmtime64(&local) - t);
 #else
-    CCLOGERROR("CCCalendar::getHour is not implemented for this platform, please finish it");
-    return 0;
+    time_t t = (time_t)seconds;
+    struct tm local;
+    if(!localtime_r(&t, &local))
+        return 0;
+    return (int)local.tm_gmtoff;
 #endif
 }
 
-int CCCalendar::getSecond() {
-#if CC_TARGET_PLATFORM == CC_PLATFORM_IOS || CC_TARGET_PLATFORM == CC_PLATFORM_MAC
-    NSCalendar* c = [NSCalendar currentCalendar];
-    NSDate* d = [NSDate dateWithTimeIntervalSince1970:m_time];
-    NSDateComponents* dc = [c components:NSSecondCalendarUnit fromDate:d];
-    return dc.second;
-#elif CC_TARGET_PLATFORM == CC_PLATFORM_ANDROID
-    jobject c = createAndroidCalendar(m_time);
-	JNIEnv* env = CCUtils::getJNIEnv();
-    int ret = env->CallIntMethod(c, CALENDAR_GET, SECOND);
-    env->DeleteLocalRef(c);
-    return ret;
-#else
-    CCLOGERROR("CCCalendar::getHour is not implemented for this platform, please finish it");
-    return 0;
-#endif
+void CCCalendar::updateFields() {
+    // get offset, only query platform when time goes out of cached window
+    int64_t seconds = floorDiv(m_time, 1000);
+    int64_t window = floorDiv(seconds, OFFSET_WINDOW);
+    if(window != m_offsetWindow || m_offsetWindow == -1) {
+        m_offset = getOffset(seconds);
+        m_offsetWindow = window;
+    }
+    
+    // split local time to days and time of day
+    int64_t local = m_time + (int64_t)m_offset * 1000;
+    int64_t days = floorDiv(local, 86400000);
+    int ms = (int)(local - days * 86400000);
+    m_fields.hour = ms / 3600000;
+    m_fields.minute = ms / 60000 % 60;
+    m_fields.second = ms / 1000 % 60;
+    m_fields.millisecond = ms % 1000;
+    
+    // 1970-1-1 is thursday
+    m_fields.weekday = (int)((days % 7 + 11) % 7) + 1;
+    
+    // civil from days, shift epoch to 0000-3-1 so that leap day is the last day of year
+    int64_t z = days + 719468;
+    int64_t era = floorDiv(z, 146097);
+    int doe = (int)(z - era * 146097);
+    int yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    int doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    int mp = (5 * doy + 2) / 153;
+    m_fields.day = doy - (153 * mp + 2) / 5 + 1;
+    m_fields.month = mp < 10 ? mp + 3 : mp - 9;
+    m_fields.year = (int)(era * 400 + yoe) + (m_fields.month <= 2 ? 1 : 0);
 }
 
 NS_CC_END
\ No newline at end of file
@@ -0,0 +1,140 @@
+/****************************************************************************
+ Author: Luma (stubma@gmail.com)
+ 
+ https://github.com/stubma/cocos2dx-common
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ ****************************************************************************/
+#include "CCClock.h"
+#if CC_TARGET_PLATFORM == CC_PLATFORM_IOS || CC_TARGET_PLATFORM == CC_PLATFORM_MAC
+	#include <mach/mach_time.h>
+#elif CC_TARGET_PLATFORM == CC_PLATFORM_WIN32
+	#include <windows.h>
+#else
+	#include <time.h>
+#endif
+
+NS_CC_BEGIN
+
+/// an object scheduled in director to take frame snapshot
+class CCClockUpdater : public CCObject {
+public:
+	virtual void update(float /*delta*/) {
+		CCClock::beginFrame();
+	}
+};
+
+/// updater scheduled by attach
+static CCClockUpdater* s_updater = NULL;
+
+int64_t CCClock::s_frameTime = 0;
+int64_t CCClock::s_frameDelta = 0;
+bool CCClock::s_hasFrame = false;
+int64_t CCClock::s_overrideTime = 0;
+bool CCClock::s_overridden = false;
+
+int64_t CCClock::systemNanoTime() {
+#if CC_TARGET_PLATFORM == CC_PLATFORM_IOS || CC_TARGET_PLATFORM == CC_PLATFORM_MAC
+	static mach_timebase_info_data_t s_timebase = { 0, 0 };
+	if(s_timebase.denom == 0) {
+		mach_timebase_info(&s_timebase);
+	}
+	
+	// split to avoid overflow of tick * numer
+	uint64_t t = mach_absolute_time();
+	return (int64_t)(t / s_timebase.denom * s_timebase.numer + t % s_timebase.denom * s_timebase.numer / s_timebase.denom);
+#elif CC_TARGET_PLATFORM == CC_PLATFORM_WIN32
+	static LARGE_INTEGER s_freq = { 0 };
+	if(s_freq.QuadPart == 0) {
+		QueryPerformanceFrequency(&s_freq);
+	}
+	
+	// split to avoid overflow of counter * 10^9
+	LARGE_INTEGER c;
+	QueryPerformanceCounter(&c);
+	return c.QuadPart / s_freq.QuadPart * 1000000000LL + c.QuadPart % s_freq.QuadPart * 1000000000LL / s_freq.QuadPart;
+#else
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+#endif
+}
+
+int64_t CCClock::nanoTime() {
+	return s_overridden ? s_overrideTime : systemNanoTime();
+}
+
+void CCClock::attach() {
+	if(!s_updater) {
+		s_updater = new CCClockUpdater();
+		CCDirector* director = CCDirector::sharedDirector();
+		CCScheduler* scheduler = director->getScheduler();
+		scheduler->scheduleUpdateForTarget(s_updater, kCCPrioritySystem, false);
+		
+		// action manager already has system priority, there is no higher one and
+		// same priority runs in schedule order, so schedule it again after updater
+		CCActionManager* actionManager = director->getActionManager();
+		scheduler->unscheduleUpdateForTarget(actionManager);
+		scheduler->scheduleUpdateForTarget(actionManager, kCCPrioritySystem, false);
+		beginFrame();
+	}
+}
+
+void CCClock::detach() {
+	if(s_updater) {
+		CCDirector::sharedDirector()->getScheduler()->unscheduleUpdateForTarget(s_updater);
+		CC_SAFE_RELEASE_NULL(s_updater);
+		
+		// no one takes snapshot now, fall back to live time
+		s_hasFrame = false;
+		s_frameDelta = 0;
+	}
+}
+
+void CCClock::beginFrame() {
+	int64_t now = nanoTime();
+	s_frameDelta = s_hasFrame ? now - s_frameTime : 0;
+	s_frameTime = now;
+	s_hasFrame = true;
+}
+
+int64_t CCClock::getFrameTime() {
+	return s_hasFrame ? s_frameTime : nanoTime();
+}
+
+void CCClock::setOverrideTime(int64_t ns) {
+	s_overrideTime = ns;
+	s_overridden = true;
+	s_hasFrame = false;
+	s_frameDelta = 0;
+}
+
+void CCClock::advanceOverrideTime(int64_t ns) {
+	if(s_overridden) {
+		s_overrideTime += ns;
+	}
+}
+
+void CCClock::clearOverrideTime() {
+	s_overridden = false;
+	s_hasFrame = false;
+	s_frameDelta = 0;
+}
+
+NS_CC_END
@@ -0,0 +1,415 @@
+/****************************************************************************
+ Author: Luma (stubma@gmail.com)
+ 
+ https://github.com/stubma/cocos2dx-common
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ ****************************************************************************/
+#include "CCCpuInfo.h"
+#include <pthread.h>
+#include <algorithm>
+#if CC_TARGET_PLATFORM == CC_PLATFORM_IOS || CC_TARGET_PLATFORM == CC_PLATFORM_MAC
+	#include <sys/sysctl.h>
+	#include <string.h>
+#elif CC_TARGET_PLATFORM == CC_PLATFORM_WIN32
+	#include <windows.h>
+	#include <intrin.h>
+#else
+	#include <unistd.h>
+	#include <stdio.h>
+	#include <string.h>
+#endif
+#if defined(__i386__) || defined(__x86_64__) || defined(_M_IX86) || defined(_M_X64)
+	#define CPU_X86
+	#ifndef _MSC_VER
+		#include <cpuid.h>
+	#endif
+#endif
+
+NS_CC_BEGIN
+
+/// load once guard
+static pthread_once_t s_once = PTHREAD_ONCE_INIT;
+
+/// cached information
+static int s_logicalCores = 1;
+static int s_physicalCores = 1;
+static int s_cacheLineSize = 64;
+static int s_l2CacheSize = 0;
+static int s_features = 0;
+static CCCpuInfo::ClusterList s_clusters;
+
+#ifdef CPU_X86
+
+/// execute cpuid, regs receives eax, ebx, ecx and edx
+static void cpuid(unsigned int leaf, unsigned int subleaf, unsigned int* regs) {
+#ifdef _MSC_VER
+	int r[4];
+	__cpuidex(r, leaf, subleaf);
+	for(int i = 0; i < 4; i++)
+		regs[i] = r[i];
+#else
+	__cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+/// read extended control register 0, it tells which register states os saves
+static uint64_t xgetbv0() {
+#ifdef _MSC_VER
+	return _xgetbv(0);
+#else
+	unsigned int lo, hi;
+	__asm__ __volatile__("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+	return ((uint64_t)hi << 32) | lo;
+#endif
+}
+
+static int queryX86Features() {
+	unsigned int r[4];
+	cpuid(0, 0, r);
+	unsigned int maxLeaf = r[0];
+	if(maxLeaf < 1)
+		return 0;
+	
+	int f = 0;
+	cpuid(1, 0, r);
+	if(r[3] & (1 << 26)) f |= CCCpuInfo::SSE2;
+	if(r[2] & (1 << 0)) f |= CCCpuInfo::SSE3;
+	if(r[2] & (1 << 9)) f |= CCCpuInfo::SSSE3;
+	if(r[2] & (1 << 19)) f |= CCCpuInfo::SSE41;
+	if(r[2] & (1 << 20)) f |= CCCpuInfo::SSE42;
+	
+	// avx is usable only when os saves xmm and ymm states
+	bool osxsave = (r[2] & (1 << 27)) != 0;
+	if(osxsave && (r[2] & (1 << 28)) && (xgetbv0() & 6) == 6) {
+		f |= CCCpuInfo::AVX;
+		if(maxLeaf >= 7) {
+			cpuid(7, 0, r);
+			if(r[1] & (1 << 5)) f |= CCCpuInfo::AVX2;
+		}
+	}
+	return f;
+}
+
+#endif // CPU_X86
+
+#if CC_TARGET_PLATFORM == CC_PLATFORM_ANDROID || CC_TARGET_PLATFORM == CC_PLATFORM_LINUX
+
+/// read an integer from sysfs, returns default value if failed
+static int64_t readSysInt(const char* path, int64_t def) {
+	FILE* f = fopen(path, "r");
+	if(!f)
+		return def;
+	long long v;
+	if(fscanf(f, "%lld", &v) != 1)
+		v = def;
+	fclose(f);
+	return v;
+}
+
+/// read a cache size from sysfs, such as 512K, returns zero if failed
+static int readSysSize(const char* path) {
+	FILE* f = fopen(path, "r");
+	if(!f)
+		return 0;
+	int v = 0;
+	char unit = 0;
+	if(fscanf(f, "%d%c", &v, &unit) < 1)
+		v = 0;
+	fclose(f);
+	if(unit == 'K')
+		v <<= 10;
+	else if(unit == 'M')
+		v <<= 20;
+	return v;
+}
+
+/// read a short string from sysfs, trailing new line is trimmed
+static bool readSysString(const char* path, char* buf, int size) {
+	FILE* f = fopen(path, "r");
+	if(!f)
+		return false;
+	bool ok = fgets(buf, size, f) != NULL;
+	fclose(f);
+	if(ok) {
+		size_t len = strlen(buf);
+		if(len > 0 && buf[len - 1] == '\n')
+			buf[len - 1] = 0;
+	}
+	return ok;
+}
+
+#if !defined(CPU_X86) && !defined(__aarch64__) && !defined(__ARM_NEON__)
+/// check neon in features line of /proc/cpuinfo, for arm32 build without neon
+static bool cpuinfoHasNeon() {
+	FILE* f = fopen("/proc/cpuinfo", "r");
+	if(!f)
+		return false;
+	char line[1024];
+	bool neon = false;
+	while(!neon && fgets(line, sizeof(line), f)) {
+		if(!strncmp(line, "Features", 8)) {
+			neon = strstr(line, " neon") != NULL || strstr(line, " asimd") != NULL;
+		}
+	}
+	fclose(f);
+	return neon;
+}
+#endif
+
+/// sort key of cluster, faster first
+static bool isFasterCluster(const CCCpuInfo::Cluster& a, const CCCpuInfo::Cluster& b) {
+	return a.maxFreq > b.maxFreq;
+}
+
+static void loadTopology() {
+	long n = sysconf(_SC_NPROCESSORS_CONF);
+	s_logicalCores = (int)MAX(n, 1);
+	
+	// read max frequency and core id of every cpu
+	char path[128];
+	vector<int64_t> freqs(s_logicalCores);
+	vector<int64_t> coreKeys;
+	coreKeys.reserve(s_logicalCores);
+	int64_t slowest = 0;
+	for(int i = 0; i < s_logicalCores; i++) {
+		sprintf(path, "/sys/devices/system/cpu/cpu%d/cpufreq/cpuinfo_max_freq", i);
+		freqs[i] = readSysInt(path, 0) * 1000;
+		if(freqs[i] > 0 && (slowest == 0 || freqs[i] < slowest))
+			slowest = freqs[i];
+		
+		sprintf(path, "/sys/devices/system/cpu/cpu%d/topology/physical_package_id", i);
+		int64_t package = readSysInt(path, 0);
+		sprintf(path, "/sys/devices/system/cpu/cpu%d/topology/core_id", i);
+		int64_t core = readSysInt(path, i);
+		coreKeys.push_back((package << 32) | (core & 0xffffffff));
+	}
+	
+	// hyper threads share same core id
+	sort(coreKeys.begin(), coreKeys.end());
+	s_physicalCores = (int)(unique(coreKeys.begin(), coreKeys.end()) - coreKeys.begin());
+	
+	// cpu which is offline may not expose frequency, treat it as slowest
+	for(int i = 0; i < s_logicalCores; i++) {
+		if(freqs[i] == 0)
+			freqs[i] = slowest;
+	}
+	
+	// group by frequency
+	for(int i = 0; i < s_logicalCores; i++) {
+		CCCpuInfo::ClusterList::iterator iter = s_clusters.begin();
+		for(; iter != s_clusters.end(); iter++) {
+			if(iter->maxFreq == freqs[i])
+				break;
+		}
+		if(iter == s_clusters.end()) {
+			CCCpuInfo::Cluster c = { 0, freqs[i], 0 };
+			s_clusters.push_back(c);
+			iter = s_clusters.end() - 1;
+		}
+		iter->coreCount++;
+		if(i < 64)
+			iter->cpuMask |= (uint64_t)1 << i;
+	}
+	stable_sort(s_clusters.begin(), s_clusters.end(), isFasterCluster);
+	
+	// cache of first core in fastest cluster
+	int cpu = 0;
+	while(cpu < 64 && !s_clusters.empty() && !(s_clusters[0].cpuMask & ((uint64_t)1 << cpu)))
+		cpu++;
+	char type[32];
+	for(int i = 0; i < 16; i++) {
+		sprintf(path, "/sys/devices/system/cpu/cpu%d/cache/index%d/level", cpu, i);
+		int level = (int)readSysInt(path, 0);
+		if(level == 0)
+			break;
+		sprintf(path, "/sys/devices/system/cpu/cpu%d/cache/index%d/type", cpu, i);
+		if(!readSysString(path, type, sizeof(type)) || !strcmp(type, "Instruction"))
+			continue;
+		if(level == 1) {
+			sprintf(path, "/sys/devices/system/cpu/cpu%d/cache/index%d/coherency_line_size", cpu, i);
+			int line = (int)readSysInt(path, 0);
+			if(line > 0)
+				s_cacheLineSize = line;
+		} else if(level == 2) {
+			sprintf(path, "/sys/devices/system/cpu/cpu%d/cache/index%d/size", cpu, i);
+			s_l2CacheSize = readSysSize(path);
+		}
+	}
+#ifdef _SC_LEVEL2_CACHE_SIZE
+	if(s_l2CacheSize <= 0)
+		s_l2CacheSize = (int)MAX(sysconf(_SC_LEVEL2_CACHE_SIZE), 0);
+#endif
+}
+
+#elif CC_TARGET_PLATFORM == CC_PLATFORM_IOS || CC_TARGET_PLATFORM == CC_PLATFORM_MAC
+
+/// read an integer by sysctl name, returns default value if failed
+static int64_t sysctlInt(const char* name, int64_t def) {
+	int64_t v = 0;
+	size_t size = sizeof(v);
+	if(sysctlbyname(name, &v, &size, NULL, 0) != 0)
+		return def;
+	
+	// some names are 32 bits
+	if(size == sizeof(int32_t)) {
+		int32_t v32;
+		memcpy(&v32, &v, sizeof(v32));
+		return v32;
+	}
+	return v;
+}
+
+static void loadTopology() {
+	s_logicalCores = (int)sysctlInt("hw.logicalcpu", sysctlInt("hw.ncpu", 1));
+	s_physicalCores = (int)sysctlInt("hw.physicalcpu", s_logicalCores);
+	s_cacheLineSize = (int)sysctlInt("hw.cachelinesize", 64);
+	
+	// perflevel0 is the fastest, frequency is not exposed for apple silicon
+	int levels = (int)sysctlInt("hw.nperflevels", 0);
+	char name[64];
+	for(int i = 0; i < levels; i++) {
+		sprintf(name, "hw.perflevel%d.logicalcpu", i);
+		CCCpuInfo::Cluster c = { (int)sysctlInt(name, 0), 0, 0 };
+		if(c.coreCount > 0)
+			s_clusters.push_back(c);
+	}
+	if(s_clusters.empty()) {
+		CCCpuInfo::Cluster c = { s_logicalCores, sysctlInt("hw.cpufrequency_max", 0), 0 };
+		s_clusters.push_back(c);
+	}
+	
+	s_l2CacheSize = (int)sysctlInt("hw.perflevel0.l2cachesize", sysctlInt("hw.l2cachesize", 0));
+}
+
+#elif CC_TARGET_PLATFORM == CC_PLATFORM_WIN32
+
+static void loadTopology() {
+	SYSTEM_INFO si;
+	GetSystemInfo(&si);
+	s_logicalCores = (int)si.dwNumberOfProcessors;
+	
+	// physical cores and caches
+	DWORD len = 0;
+	GetLogicalProcessorInformation(NULL, &len);
+	if(len > 0) {
+		vector<SYSTEM_LOGICAL_PROCESSOR_INFORMATION> infos(len / sizeof(SYSTEM_LOGICAL_PROCESSOR_INFORMATION) + 1);
+		if(GetLogicalProcessorInformation(&infos[0], &len)) {
+			int cores = 0;
+			int count = len / sizeof(SYSTEM_LOGICAL_PROCESSOR_INFORMATION);
+			for(int i = 0; i < count; i++) {
+				if(infos[i].Relationship == RelationProcessorCore) {
+					cores++;
+				} else if(infos[i].Relationship == RelationCache) {
+					CACHE_DESCRIPTOR& cache = infos[i].Cache;
+					if(cache.Level == 1 && cache.Type != CacheInstruction)
+						s_cacheLineSize = cache.LineSize;
+					else if(cache.Level == 2)
+						s_l2CacheSize = MAX(s_l2CacheSize, (int)cache.Size);
+				}
+			}
+			if(cores > 0)
+				s_physicalCores = cores;
+		}
+	}
+	
+	CCCpuInfo::Cluster c = { s_logicalCores, 0, (uint64_t)si.dwActiveProcessorMask };
+	s_clusters.push_back(c);
+}
+
+#else
+
+static void loadTopology() {
+	CCLOGWARN("CCCpuInfo is not implemented for this platform, assume single core");
+}
+
+#endif
+
+void CCCpuInfo::load() {
+	loadTopology();
+	
+	// sanitize
+	s_logicalCores = MAX(s_logicalCores, 1);
+	if(s_physicalCores < 1 || s_physicalCores > s_logicalCores)
+		s_physicalCores = s_logicalCores;
+	if(s_clusters.empty()) {
+		Cluster c = { s_logicalCores, 0, s_logicalCores < 64 ? (((uint64_t)1 << s_logicalCores) - 1) : ~(uint64_t)0 };
+		s_clusters.push_back(c);
+	}
+	
+	// simd features
+#if defined(CPU_X86)
+	s_features = queryX86Features();
+#elif defined(__aarch64__) || defined(_M_ARM64) || defined(__ARM_NEON__) || defined(__ARM_NEON)
+	s_features = NEON;
+#elif CC_TARGET_PLATFORM == CC_PLATFORM_ANDROID || CC_TARGET_PLATFORM == CC_PLATFORM_LINUX
+	s_features = cpuinfoHasNeon() ? NEON : 0;
+#endif
+}
+
+int CCCpuInfo::getLogicalCoreCount() {
+	pthread_once(&s_once, load);
+	return s_logicalCores;
+}
+
+int CCCpuInfo::getPhysicalCoreCount() {
+	pthread_once(&s_once, load);
+	return s_physicalCores;
+}
+
+const CCCpuInfo::ClusterList& CCCpuInfo::getClusters() {
+	pthread_once(&s_once, load);
+	return s_clusters;
+}
+
+int CCCpuInfo::getPerformanceCoreCount() {
+	const ClusterList& clusters = getClusters();
+	if(clusters.size() == 1)
+		return clusters[0].coreCount;
+	
+	int count = 0;
+	for(size_t i = 0; i < clusters.size() - 1; i++)
+		count += clusters[i].coreCount;
+	return count;
+}
+
+int CCCpuInfo::getRecommendedWorkerCount() {
+	return MAX(getPerformanceCoreCount() - 1, 1);
+}
+
+int64_t CCCpuInfo::getMaxFrequency() {
+	return getClusters()[0].maxFreq;
+}
+
+int CCCpuInfo::getCacheLineSize() {
+	pthread_once(&s_once, load);
+	return s_cacheLineSize;
+}
+
+int CCCpuInfo::getL2CacheSize() {
+	pthread_once(&s_once, load);
+	return s_l2CacheSize;
+}
+
+int CCCpuInfo::getFeatures() {
+	pthread_once(&s_once, load);
+	return s_features;
+}
+
+NS_CC_END
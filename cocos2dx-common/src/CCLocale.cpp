@@ -22,20 +22,49 @@
  THE SOFTWARE.
  ****************************************************************************/
 #include "CCLocale.h"
+#include <algorithm>
+#include <string.h>
 #if CC_TARGET_PLATFORM == CC_PLATFORM_IOS || CC_TARGET_PLATFORM == CC_PLATFORM_MAC
     #import <Foundation/Foundation.h>
 #elif CC_TARGET_PLATFORM == CC_PLATFORM_ANDROID
     #include "JniHelper.h"
+#elif CC_TARGET_PLATFORM == CC_PLATFORM_WIN32
+    #include <windows.h>
+#elif CC_TARGET_PLATFORM == CC_PLATFORM_LINUX
+    #include <stdlib.h>
 #endif
 
 NS_CC_BEGIN
 
 CCLocale* CCLocale::s_instance = NULL;
 
+#if CC_TARGET_PLATFORM == CC_PLATFORM_IOS || CC_TARGET_PLATFORM == CC_PLATFORM_MAC
+// observer token of locale change notification
+static id s_localeObserver = nil;
+#endif
+
 CCLocale::CCLocale() {
+    load();
+    
+#if CC_TARGET_PLATFORM == CC_PLATFORM_IOS || CC_TARGET_PLATFORM == CC_PLATFORM_MAC
+    // notification is delivered in main queue, which is also GL thread
+    s_localeObserver = [[NSNotificationCenter defaultCenter] addObserverForName:NSCurrentLocaleDidChangeNotification
+                                                                          object:nil
+                                                                           queue:[NSOperationQueue mainQueue]
+                                                                      usingBlock:^(NSNotification* n) {
+                                                                          CCLocale::sharedLocale()->notifyConfigurationChanged();
+                                                                      }];
+#endif
 }
 
 CCLocale::~CCLocale() {
+#if CC_TARGET_PLATFORM == CC_PLATFORM_IOS || CC_TARGET_PLATFORM == CC_PLATFORM_MAC
+    if(s_localeObserver) {
+        [[NSNotificationCenter defaultCenter] removeObserver:s_localeObserver];
+        s_localeObserver = nil;
+    }
+#endif
+    
     s_instance = NULL;
 }
 
@@ -46,50 +75,106 @@ CCLocale* CCLocale::sharedLocale() {
     return s_instance;
 }
 
-string CCLocale::getLanguage() {
+void CCLocale::load() {
 #if CC_TARGET_PLATFORM == CC_PLATFORM_IOS || CC_TARGET_PLATFORM == CC_PLATFORM_MAC
     // get language
-	NSString* lan = [[NSLocale preferredLanguages] objectAtIndex:0];
-	if(!lan)
-		return "en";
-    else
-        return [lan cStringUsingEncoding:NSUTF8StringEncoding];
-#elif CC_TARGET_PLATFORM == CC_PLATFORM_ANDROID
-    // get default locale
-    JniMethodInfo t;
-    JniHelper::getStaticMethodInfo(t, "java/util/Locale", "getDefault", "()Ljava/util/Locale;");
-    jobject jLocale = t.env->CallStaticObjectMethod(t.classID, t.methodID);
+	NSArray* lans = [NSLocale preferredLanguages];
+	NSString* lan = [lans count] > 0 ? [lans objectAtIndex:0] : nil;
+    m_language = lan ? [lan cStringUsingEncoding:NSUTF8StringEncoding] : "en";
     
-    // get language
-    JniHelper::getMethodInfo(t, "java/util/Locale", "getLanguage", "()Ljava/lang/String;");
-    jstring jLan = (jstring)t.env->CallObjectMethod(jLocale, t.methodID);
-    return JniHelper::jstring2string(jLan);
-#else
-    CCLOGERROR("CCLocale::getLanguage is not implemented for this platform, please finish it");
-#endif
-}
-
-string CCLocale::getCountry() {
-#if CC_TARGET_PLATFORM == CC_PLATFORM_IOS || CC_TARGET_PLATFORM == CC_PLATFORM_MAC
     // get country
 	NSString* c = [[NSLocale currentLocale] objectForKey:NSLocaleCountryCode];
-	if(!c)
-		return "US";
-    else
-        return [c cStringUsingEncoding:NSUTF8StringEncoding];
+    m_country = c ? [c cStringUsingEncoding:NSUTF8StringEncoding] : "US";
 #elif CC_TARGET_PLATFORM == CC_PLATFORM_ANDROID
     // get default locale
     JniMethodInfo t;
     JniHelper::getStaticMethodInfo(t, "java/util/Locale", "getDefault", "()Ljava/util/Locale;");
     jobject jLocale = t.env->CallStaticObjectMethod(t.classID, t.methodID);
+    t.env->DeleteLocalRef(t.classID);
     
     // get language
+    JniHelper::getMethodInfo(t, "java/util/Locale", "getLanguage", "()Ljava/lang/String;");
+    jstring jLan = (jstring)t.env->CallObjectMethod(jLocale, t.methodID);
+    m_language = JniHelper::jstring2string(jLan);
+    t.env->DeleteLocalRef(jLan);
+    t.env->DeleteLocalRef(t.classID);
+    
+    // get country
     JniHelper::getMethodInfo(t, "java/util/Locale", "getCountry", "()Ljava/lang/String;");
     jstring jCty = (jstring)t.env->CallObjectMethod(jLocale, t.methodID);
-    return JniHelper::jstring2string(jCty);
+    m_country = JniHelper::jstring2string(jCty);
+    t.env->DeleteLocalRef(jCty);
+    t.env->DeleteLocalRef(t.classID);
+    t.env->DeleteLocalRef(jLocale);
+#elif CC_TARGET_PLATFORM == CC_PLATFORM_WIN32
+    char buf[16];
+    m_language = GetLocaleInfoA(LOCALE_USER_DEFAULT, LOCALE_SISO639LANGNAME, buf, sizeof(buf)) > 0 ? buf : "en";
+    m_country = GetLocaleInfoA(LOCALE_USER_DEFAULT, LOCALE_SISO3166CTRYNAME, buf, sizeof(buf)) > 0 ? buf : "US";
+#elif CC_TARGET_PLATFORM == CC_PLATFORM_LINUX
+    // locale is in form of language[_territory][.codeset][@modifier], first non-empty one wins
+    const char* names[] = { "LC_ALL", "LC_MESSAGES", "LANG" };
+    const char* value = NULL;
+    for(int i = 0; i < 3 && !value; i++) {
+        value = getenv(names[i]);
+        if(value && !*value)
+            value = NULL;
+    }
+    m_language = "en";
+    m_country = "US";
+    if(value && strcmp(value, "C") && strcmp(value, "POSIX")) {
+        size_t lanLen = strcspn(value, "_.@");
+        if(lanLen > 0) {
+            m_language.assign(value, lanLen);
+            if(value[lanLen] == '_') {
+                const char* c = value + lanLen + 1;
+                m_country.assign(c, strcspn(c, ".@"));
+            }
+        }
+    }
 #else
-    CCLOGERROR("CCLocale::getLanguage is not implemented for this platform, please finish it");
+    CCLOGERROR("CCLocale::load is not implemented for this platform, please finish it");
+    m_language = "en";
+    m_country = "US";
 #endif
 }
 
-NS_CC_END
\ No newline at end of file
+void CCLocale::notifyConfigurationChanged() {
+    string lastLanguage = m_language;
+    string lastCountry = m_country;
+    load();
+    if(lastLanguage == m_language && lastCountry == m_country)
+        return;
+    
+    // copy list so that listener can remove itself in callback
+    ListenerList listeners = m_listeners;
+    for(ListenerList::iterator iter = listeners.begin(); iter != listeners.end(); iter++) {
+        (*iter)->onLocaleChanged(m_language, m_country);
+    }
+}
+
+void CCLocale::addListener(CCLocaleListener* l) {
+    if(!l)
+        return;
+    if(find(m_listeners.begin(), m_listeners.end(), l) == m_listeners.end()) {
+        m_listeners.push_back(l);
+    }
+}
+
+void CCLocale::removeListener(CCLocaleListener* l) {
+    ListenerList::iterator iter = find(m_listeners.begin(), m_listeners.end(), l);
+    if(iter != m_listeners.end()) {
+        m_listeners.erase(iter);
+    }
+}
+
+NS_CC_END
+
+#if CC_TARGET_PLATFORM == CC_PLATFORM_ANDROID
+
+extern "C" {
+    JNIEXPORT void JNICALL Java_org_cocos2dx_lib_SystemUtils_nativeOnLocaleChanged(JNIEnv* /*env*/, jclass /*clazz*/) {
+        cocos2d::CCLocale::sharedLocale()->notifyConfigurationChanged();
+    }
+}
+
+#endif
@@ -25,16 +25,77 @@
 #include "CCUtils.h"
 #include "CCAndroidStringsParser.h"
 #include "CCLocale.h"
+#include "CCCpuInfo.h"
 
 NS_CC_BEGIN
 
 // init static
 CCLocalization* CCLocalization::s_instance = NULL;
 
-CCLocalization::CCLocalization() {
+CCLocalization::Language::Language() :
+        loaded(false) {
+}
+
+CCLocalization::Language::~Language() {
+    reset();
+}
+
+void CCLocalization::Language::reset() {
+    for(vector<string*>::iterator iter = strings.begin(); iter != strings.end(); iter++) {
+        delete *iter;
+    }
+    for(vector<Template*>::iterator iter = templates.begin(); iter != templates.end(); iter++) {
+        delete *iter;
+    }
+    strings.assign(table.size(), (string*)NULL);
+    templates.assign(table.size(), (Template*)NULL);
+}
+
+void CCLocalization::Language::unload() {
+    table.unload();
+    reset();
+    loaded = false;
+}
+
+const string& CCLocalization::Language::stringAt(int index) {
+    string*& s = strings[index];
+    if(!s) {
+        size_t len;
+        const char* value = table.valueAt(index, &len);
+        s = new string(value, len);
+    }
+    return *s;
+}
+
+const CCLocalization::Template& CCLocalization::Language::templateAt(int index) {
+    Template*& t = templates[index];
+    if(!t) {
+        size_t len;
+        const char* value = table.valueAt(index, &len);
+        t = new Template();
+        parseTemplate(value, len, *t);
+    }
+    return *t;
+}
+
+CCLocalization::CCLocalization() :
+        m_current(NULL),
+        m_fallback(NULL),
+        m_dirty(true),
+        m_generation(1),
+        m_preloading(false) {
+    pthread_mutex_init(&m_mutex, NULL);
+    CCLocale::sharedLocale()->addListener(this);
 }
 
 CCLocalization::~CCLocalization() {
+    CCLocale::sharedLocale()->removeListener(this);
+    joinPreload();
+    for(LanguageMap::iterator iter = m_lanMap.begin(); iter != m_lanMap.end(); iter++) {
+        delete iter->second;
+    }
+    pthread_mutex_destroy(&m_mutex);
+    
     // release singleton
     if(s_instance) {
         s_instance->release();
@@ -60,52 +121,953 @@ void CCLocalization::addAndroidStrings(const string& lan, const string& path, bo
         return;
     }
     
-    // register language dictionary
-    CCDictionary* d = (CCDictionary*)m_lanMap.objectForKey(lan);
-    if(!d) {
-        d = CCDictionary::create();
-        m_lanMap.setObject(d, lan);
+    addSource(lan, path, false, merge);
+}
+
+void CCLocalization::addCompiledStrings(const string& lan, const string& path, bool merge) {
+    // basic checking
+    if(path.empty()) {
+        CCLOGWARN("CCLocalization::addCompiledStrings: string file path is empty");
+        return;
+    }
+    if(lan.length() != 2) {
+        CCLOGWARN("CCLocalization::addCompiledStrings: language code is not in ISO 639-1 format");
+        return;
+    }
+    
+    addSource(lan, path, true, merge);
+}
+
+/// work shared by batch threads
+struct CCLocalization::BatchJob {
+    /// a language in batch
+    struct LanJob {
+        /// language code
+        string lan;
+        
+        /// existing language, or NULL
+        Language* language;
+        
+        /// sources of language after batch
+        SourceList sources;
+        
+        /// true if existing strings are merged with batch files
+        bool merge;
+        
+        /// index of batch files in order
+        vector<size_t> files;
+        
+        /// content of existing sources if they are merged and not loaded
+        SourceDataList base;
+        
+        /// new table
+        CCStringTable table;
+    };
+    
+    /// batch files
+    const StringsFileList* files;
+    
+    /// content of every batch file, read in gl thread, NULL for skipped file
+    SourceDataList data;
+    
+    /// parsed strings of every xml file
+    vector<CCStringTable::Builder> builders;
+    
+    /// languages
+    vector<LanJob*> lans;
+    
+    /// 0 is parsing files, 1 is merging languages
+    int phase;
+    
+    /// next work index
+    size_t next;
+    
+    /// guards next
+    pthread_mutex_t mutex;
+    
+    /// work count of current phase
+    size_t workCount() const { return phase == 0 ? files->size() : lans.size(); }
+};
+
+void* CCLocalization::batchThread(void* arg) {
+    BatchJob* job = (BatchJob*)arg;
+    CCAndroidStringsParser parser;
+    while(true) {
+        pthread_mutex_lock(&job->mutex);
+        size_t index = job->next++;
+        pthread_mutex_unlock(&job->mutex);
+        if(index >= job->workCount())
+            break;
+        
+        if(job->phase == 0) {
+            // parse xml, or load compiled table if it is not mapped
+            SourceData* d = job->data[index];
+            if(!d || d->data.empty()) {
+                continue;
+            } else if(!d->compiled) {
+                parser.parseData(&d->data[0], d->data.size(), job->builders[index]);
+            } else if(!d->mapped) {
+                d->table.loadData(d->data);
+            }
+        } else {
+            // single compiled file is used directly
+            BatchJob::LanJob& lj = *job->lans[index];
+            if(!lj.merge && lj.files.size() == 1 && job->files->at(lj.files[0]).compiled) {
+                lj.table.swap(job->data[lj.files[0]]->table);
+                continue;
+            }
+            
+            // existing strings first, language is not changed until all threads end
+            CCStringTable::Builder merged;
+            if(lj.merge) {
+                if(lj.language->loaded) {
+                    merged.addTable(lj.language->table);
+                } else {
+                    CCStringTable base;
+                    buildSources(lj.base, base);
+                    merged.addTable(base);
+                }
+            }
+            
+            // then batch files in order
+            for(vector<size_t>::iterator iter = lj.files.begin(); iter != lj.files.end(); iter++) {
+                if(job->files->at(*iter).compiled) {
+                    merged.addTable(job->data[*iter]->table);
+                } else {
+                    merged.addBuilder(job->builders[*iter]);
+                }
+            }
+            lj.table.build(merged);
+        }
+    }
+    return NULL;
+}
+
+void CCLocalization::addStringsBatch(const StringsFileList& files, int threads) {
+    joinPreload();
+    
+    // group files by language, a replacing file discards files before it
+    BatchJob job;
+    job.files = &files;
+    job.builders.resize(files.size());
+    job.data.resize(files.size(), (SourceData*)NULL);
+    map<string, BatchJob::LanJob*> lanJobs;
+    for(size_t i = 0; i < files.size(); i++) {
+        const StringsFile& f = files[i];
+        if(f.path.empty() || f.lan.length() != 2) {
+            CCLOGWARN("CCLocalization::addStringsBatch: skip invalid file %s for language %s", f.path.c_str(), f.lan.c_str());
+            continue;
+        }
+        
+        BatchJob::LanJob*& lj = lanJobs[f.lan];
+        if(!lj) {
+            lj = new BatchJob::LanJob();
+            lj->lan = f.lan;
+            lj->language = findLanguage(f.lan);
+            if(lj->language) {
+                lj->sources = lj->language->sources;
+            }
+            lj->merge = !lj->sources.empty();
+            job.lans.push_back(lj);
+        }
+        if(!f.merge) {
+            lj->sources.clear();
+            lj->files.clear();
+            lj->merge = false;
+        }
+        Source src;
+        src.path = f.path;
+        src.compiled = f.compiled;
+        lj->sources.push_back(src);
+        lj->files.push_back(i);
+    }
+    
+    // CCFileUtils is not thread safe for files in apk, so read all files here
+    for(vector<BatchJob::LanJob*>::iterator iter = job.lans.begin(); iter != job.lans.end(); iter++) {
+        BatchJob::LanJob* lj = *iter;
+        for(vector<size_t>::iterator fi = lj->files.begin(); fi != lj->files.end(); fi++) {
+            Source src;
+            src.path = files[*fi].path;
+            src.compiled = files[*fi].compiled;
+            SourceDataList d;
+            readSources(SourceList(1, src), d);
+            job.data[*fi] = d[0];
+        }
+        if(lj->merge && !lj->language->loaded) {
+            readSources(lj->language->sources, lj->base);
+        }
+    }
+    
+    // thread count
+    if(threads <= 0)
+        threads = CCCpuInfo::getRecommendedWorkerCount();
+    pthread_mutex_init(&job.mutex, NULL);
+    
+    // parse files, then merge languages, current thread is also a worker
+    for(job.phase = 0; job.phase < 2; job.phase++) {
+        job.next = 0;
+        int n = (int)MIN((size_t)threads, job.workCount());
+        vector<pthread_t> workers;
+        for(int i = 1; i < n; i++) {
+            pthread_t t;
+            if(pthread_create(&t, NULL, batchThread, &job) == 0) {
+                workers.push_back(t);
+            } else {
+                CCLOGWARN("CCLocalization::addStringsBatch: failed to create worker thread");
+                break;
+            }
+        }
+        batchThread(&job);
+        for(vector<pthread_t>::iterator iter = workers.begin(); iter != workers.end(); iter++) {
+            pthread_join(*iter, NULL);
+        }
+    }
+    pthread_mutex_destroy(&job.mutex);
+    
+    // publish all tables at once
+    pthread_mutex_lock(&m_mutex);
+    for(vector<BatchJob::LanJob*>::iterator iter = job.lans.begin(); iter != job.lans.end(); iter++) {
+        BatchJob::LanJob* lj = *iter;
+        Language* l = lj->language;
+        if(!l) {
+            l = new Language();
+            m_lanMap[lj->lan] = l;
+        }
+        l->sources = lj->sources;
+        l->table.swap(lj->table);
+        l->reset();
+        l->loaded = true;
+        releaseSources(lj->base);
+        delete lj;
+    }
+    pthread_mutex_unlock(&m_mutex);
+    releaseSources(job.data);
+    
+    // tables are changed
+    invalidateLanguage();
+}
+
+bool CCLocalization::compileAndroidStrings(const string& xmlPath, const string& outPath) {
+    CCStringTable::Builder builder;
+    CCStringTable t;
+    return CCAndroidStringsParser::create()->parse(xmlPath, builder) && t.build(builder) && t.save(outPath);
+}
+
+void CCLocalization::addSource(const string& lan, const string& path, bool compiled, bool merge) {
+    joinPreload();
+    
+    // register language
+    Language* l = findLanguage(lan);
+    if(!l) {
+        l = new Language();
+        m_lanMap[lan] = l;
     }
     
-    // if not merge, clear first
+    // record file only, it will be loaded at first use
     if(!merge) {
-        d->removeAllObjects();
+        l->sources.clear();
     }
+    Source src;
+    src.path = path;
+    src.compiled = compiled;
+    l->sources.push_back(src);
+    l->unload();
     
-    // parse it
-    CCAndroidStringsParser::create()->parse(path, *d);
+    // table may be added or changed
+    invalidateLanguage();
 }
 
-string CCLocalization::getString(const string& key) {
-    // get strings, may fallback to English if not found
-    string lan = CCLocale::sharedLocale()->getLanguage();
-    CCDictionary* strings = (CCDictionary*)m_lanMap.objectForKey(lan);
-    if(!strings) {
-        if(lan != "en") {
-            size_t pos = lan.find("-");
-            if(pos == string::npos) {
-                strings = (CCDictionary*)m_lanMap.objectForKey("en");
+bool CCLocalization::loadSources(const SourceList& sources, CCStringTable& table) {
+    SourceDataList data;
+    readSources(sources, data);
+    bool ok = buildSources(data, table);
+    releaseSources(data);
+    return ok;
+}
+
+void CCLocalization::readSources(const SourceList& sources, SourceDataList& out) {
+    for(SourceList::const_iterator iter = sources.begin(); iter != sources.end(); iter++) {
+        SourceData* d = new SourceData();
+        d->compiled = iter->compiled;
+        d->mapped = d->compiled && d->table.mapFile(iter->path);
+        if(!d->mapped) {
+            // file may be in apk
+            unsigned long size = 0;
+            string localPath = CCUtils::mapLocalPath(iter->path);
+            unsigned char* buf = CCFileUtils::sharedFileUtils()->getFileData(localPath.c_str(), "rb", &size);
+            if(buf) {
+                d->data.assign(buf, buf + size);
+                free(buf);
             } else {
-                string primaryKey = lan.substr(0, pos);
-                strings = (CCDictionary*)m_lanMap.objectForKey(primaryKey);
-                if(!strings) {
-                    strings = (CCDictionary*)m_lanMap.objectForKey("en");
-                }
+                CCLOGWARN("CCLocalization::readSources: can't read %s", iter->path.c_str());
             }
         }
+        out.push_back(d);
+    }
+}
+
+bool CCLocalization::buildSources(SourceDataList& sources, CCStringTable& table) {
+    // single compiled file is used directly
+    if(sources.size() == 1 && sources[0]->compiled) {
+        SourceData* d = sources[0];
+        if(d->mapped) {
+            table.swap(d->table);
+            return true;
+        }
+        return table.loadData(d->data);
     }
     
-    // find string, or return empty if not found
-    if(strings) {
-        CCString* s = (CCString*)strings->objectForKey(key);
-        if(s) {
-            return s->getCString();
+    // merge all files, don't use autoreleased parser because it may run in other thread
+    CCStringTable::Builder builder;
+    CCAndroidStringsParser parser;
+    for(SourceDataList::iterator iter = sources.begin(); iter != sources.end(); iter++) {
+        SourceData* d = *iter;
+        if(d->compiled) {
+            if(d->mapped || d->table.loadData(d->data)) {
+                builder.addTable(d->table);
+            }
+        } else if(!d->data.empty()) {
+            parser.parseData(&d->data[0], d->data.size(), builder);
+        }
+    }
+    return table.build(builder);
+}
+
+void CCLocalization::releaseSources(SourceDataList& sources) {
+    for(SourceDataList::iterator iter = sources.begin(); iter != sources.end(); iter++) {
+        delete *iter;
+    }
+    sources.clear();
+}
+
+void CCLocalization::ensureLoaded(Language* l) {
+    if(!l)
+        return;
+    
+    // it may be loaded by preload thread
+    pthread_mutex_lock(&m_mutex);
+    bool loaded = l->loaded;
+    pthread_mutex_unlock(&m_mutex);
+    if(loaded)
+        return;
+    
+    // preload thread may be loading it, wait it and check again
+    joinPreload();
+    if(!l->loaded) {
+        loadSources(l->sources, l->table);
+        l->reset();
+        l->loaded = true;
+    }
+}
+
+void CCLocalization::joinPreload() {
+    if(m_preloading) {
+        pthread_join(m_preloadThread, NULL);
+        m_preloading = false;
+        releaseSources(m_preloadData);
+    }
+}
+
+void* CCLocalization::preloadThread(void* arg) {
+    Language* l = (Language*)arg;
+    
+    // files are read in gl thread, only parse and build here
+    CCLocalization* loc = sharedLocalization();
+    CCStringTable t;
+    buildSources(loc->m_preloadData, t);
+    
+    // publish
+    pthread_mutex_lock(&loc->m_mutex);
+    if(!l->loaded) {
+        l->table.swap(t);
+        l->reset();
+        l->loaded = true;
+    }
+    pthread_mutex_unlock(&loc->m_mutex);
+    return NULL;
+}
+
+void CCLocalization::preloadLanguage(const string& lan) {
+    joinPreload();
+    Language* l = findLanguage(lan);
+    if(!l || l->loaded)
+        return;
+    
+    // CCFileUtils is not thread safe for files in apk, so read files here
+    readSources(l->sources, m_preloadData);
+    if(pthread_create(&m_preloadThread, NULL, preloadThread, l) == 0) {
+        m_preloading = true;
+    } else {
+        CCLOGWARN("CCLocalization::preloadLanguage: failed to create preload thread");
+        releaseSources(m_preloadData);
+    }
+}
+
+void CCLocalization::unloadUnusedLanguages() {
+    if(m_dirty) {
+        resolveLanguage();
+    }
+    
+    joinPreload();
+    for(LanguageMap::iterator iter = m_lanMap.begin(); iter != m_lanMap.end(); iter++) {
+        Language* l = iter->second;
+        if(l != m_current && l != m_fallback && l->loaded) {
+            l->unload();
+        }
+    }
+}
+
+void CCLocalization::invalidateLanguage() {
+    // placeholders of missing keys don't depend on language, they are kept
+    m_dirty = true;
+}
+
+void CCLocalization::onLocaleChanged(const string& /*language*/, const string& /*country*/) {
+    invalidateLanguage();
+}
+
+CCLocalization::Language* CCLocalization::findLanguage(const string& lan) {
+    LanguageMap::iterator iter = m_lanMap.find(lan);
+    return iter == m_lanMap.end() ? NULL : iter->second;
+}
+
+void CCLocalization::resolveLanguage() {
+    // get strings, may fallback to primary language or English if not found
+    string lan = CCLocale::sharedLocale()->getLanguage();
+    Language* en = findLanguage("en");
+    Language* last = m_current;
+    m_current = findLanguage(lan);
+    if(!m_current) {
+        size_t pos = lan.find("-");
+        if(pos != string::npos) {
+            m_current = findLanguage(lan.substr(0, pos));
+        }
+        if(!m_current) {
+            m_current = en;
+        }
+    }
+    m_fallback = m_current == en ? NULL : en;
+    m_dirty = false;
+    
+    // remember code of current language for plural rules
+    m_currentCode = "en";
+    for(LanguageMap::iterator iter = m_lanMap.begin(); iter != m_lanMap.end(); iter++) {
+        if(iter->second == m_current) {
+            m_currentCode = iter->first;
+            break;
+        }
+    }
+    m_generation++;
+    
+    // load used languages, and release others if language is changed
+    ensureLoaded(m_current);
+    ensureLoaded(m_fallback);
+    if(last && last != m_current) {
+        unloadUnusedLanguages();
+    }
+}
+CCLocalization::Language* CCLocalization::findKey(const char* key, size_t len, int* index) {
+    if(m_dirty) {
+        resolveLanguage();
+    }
+    
+    // find in current language, then English
+    if(m_current) {
+        *index = m_current->table.indexOf(key, len);
+        if(*index != -1)
+            return m_current;
+    }
+    if(m_fallback) {
+        *index = m_fallback->table.indexOf(key, len);
+        if(*index != -1)
+            return m_fallback;
+    }
+    return NULL;
+}
+
+CCLocalization::Language* CCLocalization::findKey(const CCLKey& key, int* index) {
+    if(m_dirty) {
+        resolveLanguage();
+    }
+    
+    // cached index is valid until language is resolved again
+    if(key.m_generation != m_generation) {
+        int i = -1;
+        if(m_current) {
+            i = m_current->table.indexOfHash(key.m_hash);
+        }
+        if(i == -1 && m_fallback) {
+            i = m_fallback->table.indexOfHash(key.m_hash);
+            if(i != -1)
+                i = -i - 2;
+        }
+        key.m_index = i;
+        key.m_generation = m_generation;
+    }
+    
+    // decode index
+    Language* l;
+    if(key.m_index >= 0) {
+        *index = key.m_index;
+        l = m_current;
+    } else if(key.m_index < -1) {
+        *index = -key.m_index - 2;
+        l = m_fallback;
+    } else {
+        return NULL;
+    }
+    
+#if COCOS2D_DEBUG > 0
+    // hash is unique in table, but a missing key may collide with another key
+    size_t len;
+    const char* k = l->table.keyAt(*index, &len);
+    if(len != key.m_length || memcmp(k, key.m_key, len)) {
+        CCLOGERROR("CCLocalization: hash of key %s collides with %s", key.m_key, k);
+        return NULL;
+    }
+#endif
+    
+    return l;
+}
+
+const string& CCLocalization::getMissing(const char* key, size_t len) {
+    // placeholder is created only once
+    string k(key, len);
+    map<string, string>::iterator iter = m_missing.find(k);
+    if(iter == m_missing.end()) {
+        iter = m_missing.insert(make_pair(k, "!" + k + "!")).first;
+    }
+    return iter->second;
+}
+
+const string& CCLocalization::getString(const string& key) {
+    int index;
+    Language* l = findKey(key.c_str(), key.length(), &index);
+    return l ? l->stringAt(index) : getMissing(key.c_str(), key.length());
+}
+
+const string& CCLocalization::getString(const char* key) {
+    int index;
+    size_t len = strlen(key);
+    Language* l = findKey(key, len, &index);
+    return l ? l->stringAt(index) : getMissing(key, len);
+}
+
+const string& CCLocalization::getString(const CCLKey& key) {
+    int index;
+    Language* l = findKey(key, &index);
+    return l ? l->stringAt(index) : getMissing(key.m_key, key.m_length);
+}
+
+const char* CCLocalization::getCString(const char* key, size_t len) {
+    int index;
+    Language* l = findKey(key, len, &index);
+    return l ? l->table.valueAt(index) : NULL;
+}
+
+const char* CCLocalization::getCString(const CCLKey& key) {
+    int index;
+    Language* l = findKey(key, &index);
+    return l ? l->table.valueAt(index) : NULL;
+}
+
+void CCLocalization::parseTemplate(const char* value, size_t len, Template& t) {
+    const char* p = value;
+    const char* end = value + len;
+    const char* literal = p;
+    int nextArg = 0;
+    while(p < end) {
+        const char* percent = (const char*)memchr(p, '%', end - p);
+        if(!percent)
+            break;
+        
+        // parse %[index$][flags][width][.precision]conversion
+        const char* q = percent + 1;
+        int arg = -1;
+        const char* digits = q;
+        int number = 0;
+        while(q < end && *q >= '0' && *q <= '9') {
+            number = number * 10 + (*q - '0');
+            q++;
+        }
+        if(q < end && *q == '$' && q > digits && number > 0) {
+            arg = number - 1;
+            q++;
+        } else {
+            q = digits;
+        }
+        const char* spec = q;
+        while(q < end && strchr("-#+ 0,(", *q))
+            q++;
+        int width = 0;
+        while(q < end && *q >= '0' && *q <= '9')
+            width = width * 10 + (*q++ - '0');
+        int precision = -1;
+        if(q < end && *q == '.') {
+            q++;
+            precision = 0;
+            while(q < end && *q >= '0' && *q <= '9')
+                precision = precision * 10 + (*q++ - '0');
+        }
+        if(q >= end) {
+            break;
+        }
+        char conversion = *q++;
+        
+        // flush literal before placeholder
+        Segment seg;
+        memset(&seg, 0, sizeof(seg));
+        if(conversion == '%' || conversion == 'n' || strchr("sSdioxXcfFeEgGaAb", conversion)) {
+            if(percent > literal) {
+                seg.arg = SEGMENT_LITERAL;
+                seg.offset = (uint32_t)(literal - value);
+                seg.length = (uint32_t)(percent - literal);
+                t.push_back(seg);
+            }
+            literal = q;
         } else {
-            return "!" + key + "!";
+            // unknown conversion, keep it as literal text
+            p = q;
+            continue;
         }
+        
+        if(conversion == '%') {
+            // keep the second % as literal
+            seg.arg = SEGMENT_LITERAL;
+            seg.offset = (uint32_t)(q - 1 - value);
+            seg.length = 1;
+        } else if(conversion == 'n') {
+            seg.arg = SEGMENT_NEWLINE;
+        } else {
+            // printf spec, without java only flags, width and precision are limited
+            // so that a number never exceeds format buffer
+            seg.arg = arg >= 0 ? arg : nextArg++;
+            seg.conversion = conversion;
+            char* out = seg.spec;
+            *out++ = '%';
+            for(const char* f = spec; f < end && strchr("-#+ 0", *f) && out < seg.spec + 6; f++) {
+                *out++ = *f;
+            }
+            if(width > 0)
+                out += sprintf(out, "%d", MIN(width, 64));
+            if(precision >= 0)
+                out += sprintf(out, ".%d", MIN(precision, 64));
+            *out = 0;
+        }
+        t.push_back(seg);
+        p = q;
+    }
+    
+    // tail literal
+    if(end > literal) {
+        Segment seg;
+        memset(&seg, 0, sizeof(seg));
+        seg.arg = SEGMENT_LITERAL;
+        seg.offset = (uint32_t)(literal - value);
+        seg.length = (uint32_t)(end - literal);
+        t.push_back(seg);
+    }
+}
+
+/// largest length not greater than n which doesn't split an UTF-8 character of s, s[n] must be valid
+static inline size_t utf8Boundary(const char* s, size_t n) {
+    while(n > 0 && ((unsigned char)s[n] & 0xC0) == 0x80)
+        n--;
+    return n;
+}
+
+/**
+ * append bytes to buffer, truncated at character boundary if buffer is full. Once
+ * truncated, size is shrunk so that nothing can be appended after broken text
+ */
+static inline void appendBytes(char* buf, size_t& size, size_t& pos, const char* s, size_t len) {
+    if(pos + 1 < size) {
+        size_t n = len;
+        if(n > size - 1 - pos) {
+            n = utf8Boundary(s, size - 1 - pos);
+            size = pos + n + 1;
+        }
+        memcpy(buf + pos, s, n);
+        pos += n;
+    }
+}
+
+/// format a string argument with printf width and precision, by hand so it needn't be copied
+static void appendString(char* buf, size_t& size, size_t& pos, const char* spec, const char* s) {
+    bool left = false;
+    int width = 0;
+    int precision = -1;
+    for(const char* p = spec + 1; *p; p++) {
+        if(*p == '-') {
+            left = true;
+        } else if(*p >= '1' && *p <= '9') {
+            width = atoi(p);
+            while(p[1] >= '0' && p[1] <= '9')
+                p++;
+        } else if(*p == '.') {
+            precision = atoi(p + 1);
+            break;
+        }
+    }
+    
+    size_t len = strlen(s);
+    if(precision >= 0 && (size_t)precision < len)
+        len = utf8Boundary(s, precision);
+    size_t pad = (size_t)width > len ? width - len : 0;
+    if(!left) {
+        for(size_t i = 0; i < pad; i++)
+            appendBytes(buf, size, pos, " ", 1);
+    }
+    appendBytes(buf, size, pos, s, len);
+    if(left) {
+        for(size_t i = 0; i < pad; i++)
+            appendBytes(buf, size, pos, " ", 1);
+    }
+}
+
+int CCLocalization::formatIndex(char* buf, size_t size, Language* l, int index, const char* key, size_t len,
+                                const CCLArg* args, int argc) {
+    size_t pos = 0;
+    if(!args)
+        argc = 0;
+    
+    if(!l) {
+        // missing key placeholder
+        appendBytes(buf, size, pos, "!", 1);
+        appendBytes(buf, size, pos, key, len);
+        appendBytes(buf, size, pos, "!", 1);
     } else {
-        return "!" + key + "!";
+        const char* value = l->table.valueAt(index);
+        const Template& t = l->templateAt(index);
+        char spec[24];
+        char tmp[512];
+        for(Template::const_iterator iter = t.begin(); iter != t.end(); iter++) {
+            const Segment& seg = *iter;
+            if(seg.arg == SEGMENT_LITERAL) {
+                appendBytes(buf, size, pos, value + seg.offset, seg.length);
+                continue;
+            } else if(seg.arg == SEGMENT_NEWLINE) {
+                appendBytes(buf, size, pos, "\n", 1);
+                continue;
+            } else if(seg.arg >= argc) {
+                // no argument, keep placeholder as is
+                appendBytes(buf, size, pos, seg.spec, strlen(seg.spec));
+                appendBytes(buf, size, pos, &seg.conversion, 1);
+                continue;
+            }
+            
+            // convert argument by conversion char
+            const CCLArg& a = args[seg.arg];
+            int n = 0;
+            switch(seg.conversion) {
+                case 's':
+                case 'S':
+                    if(a.m_type == CCLArg::STRING) {
+                        appendString(buf, size, pos, seg.spec, a.m_string);
+                    } else {
+                        sprintf(spec, "%s%s", seg.spec, a.m_type == CCLArg::INT ? "lld" : "g");
+                        n = a.m_type == CCLArg::INT ? sprintf(tmp, spec, (long long)a.m_int) : sprintf(tmp, spec, a.m_double);
+                    }
+                    break;
+                case 'd':
+                case 'i':
+                case 'o':
+                case 'x':
+                case 'X':
+                    sprintf(spec, "%sll%c", seg.spec, seg.conversion);
+                    n = sprintf(tmp, spec, a.m_type == CCLArg::DOUBLE ? (long long)a.m_double :
+                                (a.m_type == CCLArg::INT ? (long long)a.m_int : (long long)atof(a.m_string)));
+                    break;
+                case 'c':
+                    if(a.m_type == CCLArg::STRING) {
+                        appendBytes(buf, size, pos, a.m_string, MIN(strlen(a.m_string), (size_t)1));
+                    } else {
+                        // char code of zero is skipped, it would end the string
+                        tmp[0] = (char)(a.m_type == CCLArg::DOUBLE ? (long long)a.m_double : a.m_int);
+                        n = tmp[0] ? 1 : 0;
+                    }
+                    break;
+                case 'b':
+                    n = sprintf(tmp, "%s", (a.m_type == CCLArg::STRING ? a.m_string[0] != 0 : a.m_int != 0 || a.m_double != 0) ? "true" : "false");
+                    break;
+                default:
+                    sprintf(spec, "%s%c", seg.spec, seg.conversion);
+                    n = sprintf(tmp, spec, a.m_type == CCLArg::DOUBLE ? a.m_double :
+                                (a.m_type == CCLArg::INT ? (double)a.m_int : atof(a.m_string)));
+                    break;
+            }
+            if(n > 0)
+                appendBytes(buf, size, pos, tmp, n);
+        }
+    }
+    
+    if(size > 0)
+        buf[pos] = 0;
+    return (int)pos;
+}
+
+int CCLocalization::formatArgs(char* buf, size_t size, const char* key, const CCLArg* args, int argc) {
+    int index;
+    size_t len = strlen(key);
+    Language* l = findKey(key, len, &index);
+    return formatIndex(buf, size, l, index, key, len, args, argc);
+}
+
+int CCLocalization::formatArgs(char* buf, size_t size, const CCLKey& key, const CCLArg* args, int argc) {
+    int index;
+    Language* l = findKey(key, &index);
+    return formatIndex(buf, size, l, index, key.m_key, key.m_length, args, argc);
+}
+
+CCLocalization::Language* CCLocalization::findPlural(const char* key, size_t len, uint64_t keyHash, int64_t quantity, int* index) {
+    if(m_dirty) {
+        resolveLanguage();
     }
+    
+    // item key is name#category, hash of it continues from hash of name
+    const char* categories[] = { getPluralCategory(m_currentCode, quantity), "other" };
+    Language* languages[] = { m_current, m_fallback };
+    for(int c = 0; c < 2; c++) {
+        const char* category = categories[c];
+        size_t categoryLength = strlen(category);
+        uint64_t h = CCStringTable::hash(category, categoryLength, CCStringTable::hash("#", 1, keyHash));
+        for(int i = 0; i < 2; i++) {
+            Language* l = languages[i];
+            if(!l)
+                continue;
+            int idx = l->table.indexOfHash(h);
+            if(idx == -1)
+                continue;
+            
+            // verify key
+            size_t itemLength;
+            const char* item = l->table.keyAt(idx, &itemLength);
+            if(itemLength == len + 1 + categoryLength && !memcmp(item, key, len) && item[len] == '#' &&
+               !memcmp(item + len + 1, category, categoryLength)) {
+                *index = idx;
+                return l;
+            }
+        }
+    }
+    return NULL;
+}
+
+int CCLocalization::formatPluralArgs(char* buf, size_t size, const char* key, int64_t quantity, const CCLArg* args, int argc) {
+    int index;
+    size_t len = strlen(key);
+    Language* l = findPlural(key, len, CCStringTable::hash(key, len), quantity, &index);
+    if(!args) {
+        CCLArg q((long long)quantity);
+        return formatIndex(buf, size, l, index, key, len, &q, 1);
+    }
+    return formatIndex(buf, size, l, index, key, len, args, argc);
+}
+
+int CCLocalization::formatPluralArgs(char* buf, size_t size, const CCLKey& key, int64_t quantity, const CCLArg* args, int argc) {
+    int index;
+    Language* l = findPlural(key.m_key, key.m_length, key.m_hash, quantity, &index);
+    if(!args) {
+        CCLArg q((long long)quantity);
+        return formatIndex(buf, size, l, index, key.m_key, key.m_length, &q, 1);
+    }
+    return formatIndex(buf, size, l, index, key.m_key, key.m_length, args, argc);
+}
+
+const char* CCLocalization::getPluralCategory(const string& lan, int64_t quantity) {
+    // primary language subtag
+    string code = lan.substr(0, lan.find('-'));
+    int64_t n = quantity < 0 ? -quantity : quantity;
+    int64_t n10 = n % 10;
+    int64_t n100 = n % 100;
+    
+    // no plural
+    if(code == "ja" || code == "zh" || code == "ko" || code == "vi" || code == "th" ||
+       code == "id" || code == "ms" || code == "my" || code == "lo" || code == "km") {
+        return "other";
+    }
+    
+    // 0 and 1 are singular
+    if(code == "fr" || code == "pt" || code == "hi" || code == "bn" || code == "fa") {
+        return n <= 1 ? "one" : "other";
+    }
+    
+    // slavic with many
+    if(code == "ru" || code == "uk" || code == "be") {
+        if(n10 == 1 && n100 != 11)
+            return "one";
+        if(n10 >= 2 && n10 <= 4 && (n100 < 12 || n100 > 14))
+            return "few";
+        return "many";
+    }
+    if(code == "pl") {
+        if(n == 1)
+            return "one";
+        if(n10 >= 2 && n10 <= 4 && (n100 < 12 || n100 > 14))
+            return "few";
+        return "many";
+    }
+    
+    // slavic without many
+    if(code == "hr" || code == "sr" || code == "bs") {
+        if(n10 == 1 && n100 != 11)
+            return "one";
+        if(n10 >= 2 && n10 <= 4 && (n100 < 12 || n100 > 14))
+            return "few";
+        return "other";
+    }
+    if(code == "cs" || code == "sk") {
+        if(n == 1)
+            return "one";
+        if(n >= 2 && n <= 4)
+            return "few";
+        return "other";
+    }
+    
+    // others
+    if(code == "ar") {
+        if(n == 0)
+            return "zero";
+        if(n == 1)
+            return "one";
+        if(n == 2)
+            return "two";
+        if(n100 >= 3 && n100 <= 10)
+            return "few";
+        if(n100 >= 11)
+            return "many";
+        return "other";
+    }
+    if(code == "he" || code == "iw") {
+        if(n == 1)
+            return "one";
+        if(n == 2)
+            return "two";
+        return "other";
+    }
+    if(code == "lt") {
+        if(n10 == 1 && (n100 < 11 || n100 > 19))
+            return "one";
+        if(n10 >= 2 && (n100 < 11 || n100 > 19))
+            return "few";
+        return "other";
+    }
+    if(code == "lv") {
+        if(n10 == 0 || (n100 >= 11 && n100 <= 19))
+            return "zero";
+        if(n10 == 1 && n100 != 11)
+            return "one";
+        return "other";
+    }
+    if(code == "ro") {
+        if(n == 1)
+            return "one";
+        if(n == 0 || (n100 >= 2 && n100 <= 19))
+            return "few";
+        return "other";
+    }
+    
+    // English, German, Spanish, Italian and most others
+    return n == 1 ? "one" : "other";
 }
 
-NS_CC_END
\ No newline at end of file
+NS_CC_END
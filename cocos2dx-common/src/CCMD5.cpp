@@ -22,27 +22,28 @@
  THE SOFTWARE.
  ****************************************************************************/
 #include "CCMD5.h"
+#include "CCUtils.h"
 #include <stdlib.h>
 #include <stdio.h>
-#include <stdio.h>
 #include <string.h>
-#include <math.h>
-#include <ctype.h>
+#include <stdint.h>
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-/* POINTER defines a generic pointer type */
-typedef unsigned char* POINTER;
+/* UINT4 defines a four byte word, long is 8 bytes in LP64 so it must be explicit */
+typedef uint32_t UINT4;
 
-/* UINT2 defines a two byte word */
-typedef unsigned short int UINT2;
+/* little endian cpu can load message words directly */
+#if (defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__) || defined(_M_IX86) || defined(_M_X64) || defined(_M_ARM)
+	#define MD5_LITTLE_ENDIAN 1
+#endif
 
-/* UINT4 defines a four byte word */
-typedef unsigned long int UINT4;
+/* hex digits for string output */
+static const char HEX_DIGITS[] = "0123456789abcdef";
 
-static unsigned char PADDING[64]= {
+static const unsigned char PADDING[64]= {
 	 0x80, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
 		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
 		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
@@ -70,17 +71,18 @@ Constants for MD5Transform routine.
 #define S44 21
 
 /*
-F, G, H and I are basic MD5 functions.
+F, G, H and I are basic MD5 functions. F and G are written in the
+equivalent form which saves one operation.
 */
-#define F(x, y, z) (((x) & (y)) | ((~x) & (z)))
-#define G(x, y, z) (((x) & (z)) | ((y) & (~z)))
+#define F(x, y, z) ((z) ^ ((x) & ((y) ^ (z))))
+#define G(x, y, z) ((y) ^ ((z) & ((x) ^ (y))))
 #define H(x, y, z) ((x) ^ (y) ^ (z))
 #define I(x, y, z) ((y) ^ ((x) | (~z)))
 
 /*
 ROTATE_LEFT rotates x left n bits.
 */
-#define ROTATE_LEFT(x, n) (((x) << (n)) | ((x) >> (32-(n))))
+#define ROTATE_LEFT(x, n) ((UINT4)(((x) << (n)) | ((x) >> (32-(n)))))
 
 /*
 FF, GG, HH, and II transformations for rounds 1, 2, 3, and 4.
@@ -91,27 +93,13 @@ Rotation is separate from addition to prevent recomputation.
 #define HH(a, b, c, d, x, s, ac) {  (a) += H ((b), (c), (d)) + (x) + (UINT4)(ac); (a) = ROTATE_LEFT ((a), (s)); (a) += (b); }
 #define II(a, b, c, d, x, s, ac) { (a) += I ((b), (c), (d)) + (x) + (UINT4)(ac); (a) = ROTATE_LEFT ((a), (s)); (a) += (b); }
 
-typedef struct _MD5_CTX {
-	UINT4 state[4]; /* state (ABCD) */
-	UINT4 count[2]; /* number of bits, modulo 2^64 (lsb first) */
-	unsigned char buffer[64]; /* input buffer */
-} MD5_CTX;
-
-static void MD5_memcpy(POINTER output, POINTER input, size_t len) {
-	size_t i;
-
-	for (i = 0; i < len; i++)
-		output[i] = input[i];
-}
+/* context is public so caller can hold it for incremental hashing */
+typedef ccMD5Context MD5_CTX;
 
-static void MD5_memset(POINTER output, int value, size_t len) {
-	size_t i;
+/* chunk size when hashing a stream or file */
+#define MD5_CHUNK_SIZE (64 * 1024)
 
-	for (i = 0; i < len; i++)
-		((char*)output)[i] = (char)value;
-}
-
-static void Encode(unsigned char* output, UINT4 *input, size_t len) {
+static void Encode(unsigned char* output, const UINT4 *input, size_t len) {
 	size_t i, j;
 
 	for (i = 0, j = 0; j < len; i++, j += 4) {
@@ -122,15 +110,19 @@ static void Encode(unsigned char* output, UINT4 *input, size_t len) {
 	}
 }
 
-static void Decode(UINT4 *output, unsigned char* input, size_t len) {
+static void Decode(UINT4 *output, const unsigned char* input, size_t len) {
+#ifdef MD5_LITTLE_ENDIAN
+	memcpy(output, input, len);
+#else
 	size_t i, j;
 
 	for (i = 0, j = 0; j < len; i++, j += 4)
 		output[i] = ((UINT4)input[j]) | (((UINT4)input[j+1]) << 8) |
 		(((UINT4)input[j+2]) << 16) | (((UINT4)input[j+3]) << 24);
+#endif
 }
 
-static void MD5Transform(UINT4 state[4], unsigned char block[64]) {
+static void MD5Transform(UINT4 state[4], const unsigned char block[64]) {
 	UINT4 a = state[0], b = state[1], c = state[2], d = state[3], x[16];
 
 	Decode (x, block, 64);
@@ -211,9 +203,6 @@ static void MD5Transform(UINT4 state[4], unsigned char block[64]) {
 	state[1] += b;
 	state[2] += c;
 	state[3] += d;
-
-	/* Zeroize sensitive information. */
-	MD5_memset((POINTER)x, 0, sizeof(x));
 }
 
 static void MD5Init(MD5_CTX *context) {
@@ -224,7 +213,7 @@ static void MD5Init(MD5_CTX *context) {
 	context->state[3] = 0x10325476;
 }
 
-static void MD5Update(MD5_CTX *context, unsigned char* input, size_t inputLen) {
+static void MD5Update(MD5_CTX *context, const unsigned char* input, size_t inputLen) {
 	size_t i, index, partLen;
 
 	/* Compute number of bytes mod 64 */
@@ -240,8 +229,7 @@ static void MD5Update(MD5_CTX *context, unsigned char* input, size_t inputLen) {
 
 	/* Transform as many times as possible. */
 	if (inputLen >= partLen) {
-		MD5_memcpy
-			((POINTER)&context->buffer[index], (POINTER)input, partLen);
+		memcpy(&context->buffer[index], input, partLen);
 		MD5Transform (context->state, context->buffer);
 
 		for (i = partLen; i + 63 < inputLen; i += 64)
@@ -253,9 +241,7 @@ static void MD5Update(MD5_CTX *context, unsigned char* input, size_t inputLen) {
 		i = 0;
 
 	/* Buffer remaining input */
-	MD5_memcpy
-		((POINTER)&context->buffer[index], (POINTER)&input[i],
-		inputLen-i);
+	memcpy(&context->buffer[index], &input[i], inputLen-i);
 }
 
 static void MD5Final(unsigned char digest[16], MD5_CTX *context) {
@@ -277,43 +263,369 @@ static void MD5Final(unsigned char digest[16], MD5_CTX *context) {
 	Encode (digest, context->state, 16);
 
 	/* Zeroize sensitive information. */
-	MD5_memset ((POINTER)context, 0, sizeof (*context));
+	memset(context, 0, sizeof (*context));
+}
+
+/*
+Multi-buffer MD5. Independent messages are hashed in parallel lanes, one
+message per lane. Every step feeds one 64 bytes block of each lane to a
+vectorized transform, and a lane picks next message once its own message
+is done, so messages of different lengths can share one batch.
+*/
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#include <emmintrin.h>
+	#define MD5_LANES 4
+	typedef __m128i VUINT4;
+	#define V_LOAD(p) _mm_loadu_si128((const __m128i*)(p))
+	#define V_STORE(p, v) _mm_storeu_si128((__m128i*)(p), (v))
+	#define V_SET1(x) _mm_set1_epi32((int)(x))
+	#define V_ADD(a, b) _mm_add_epi32((a), (b))
+	#define V_AND(a, b) _mm_and_si128((a), (b))
+	#define V_OR(a, b) _mm_or_si128((a), (b))
+	#define V_XOR(a, b) _mm_xor_si128((a), (b))
+	#define V_ROTATE_LEFT(x, n) _mm_or_si128(_mm_slli_epi32((x), (n)), _mm_srli_epi32((x), 32-(n)))
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+	#include <arm_neon.h>
+	#define MD5_LANES 4
+	typedef uint32x4_t VUINT4;
+	#define V_LOAD(p) vld1q_u32((const uint32_t*)(p))
+	#define V_STORE(p, v) vst1q_u32((uint32_t*)(p), (v))
+	#define V_SET1(x) vdupq_n_u32((uint32_t)(x))
+	#define V_ADD(a, b) vaddq_u32((a), (b))
+	#define V_AND(a, b) vandq_u32((a), (b))
+	#define V_OR(a, b) vorrq_u32((a), (b))
+	#define V_XOR(a, b) veorq_u32((a), (b))
+	#define V_ROTATE_LEFT(x, n) vsriq_n_u32(vshlq_n_u32((x), (n)), (x), 32-(n))
+#endif
+
+#ifdef MD5_LANES
+
+#define VF(x, y, z) V_XOR((z), V_AND((x), V_XOR((y), (z))))
+#define VG(x, y, z) V_XOR((y), V_AND((z), V_XOR((x), (y))))
+#define VH(x, y, z) V_XOR(V_XOR((x), (y)), (z))
+#define VI(x, y, z) V_XOR((y), V_OR((x), V_XOR((z), ones)))
+
+#define VFF(a, b, c, d, x, s, ac) { (a) = V_ADD((a), V_ADD(VF((b), (c), (d)), V_ADD((x), V_SET1(ac)))); (a) = V_ROTATE_LEFT((a), (s)); (a) = V_ADD((a), (b)); }
+#define VGG(a, b, c, d, x, s, ac) { (a) = V_ADD((a), V_ADD(VG((b), (c), (d)), V_ADD((x), V_SET1(ac)))); (a) = V_ROTATE_LEFT((a), (s)); (a) = V_ADD((a), (b)); }
+#define VHH(a, b, c, d, x, s, ac) { (a) = V_ADD((a), V_ADD(VH((b), (c), (d)), V_ADD((x), V_SET1(ac)))); (a) = V_ROTATE_LEFT((a), (s)); (a) = V_ADD((a), (b)); }
+#define VII(a, b, c, d, x, s, ac) { (a) = V_ADD((a), V_ADD(VI((b), (c), (d)), V_ADD((x), V_SET1(ac)))); (a) = V_ROTATE_LEFT((a), (s)); (a) = V_ADD((a), (b)); }
+
+/* state of one lane */
+typedef struct _MD5_LANE {
+	const unsigned char* data; /* next full block of message */
+	size_t blocks; /* full blocks left in message */
+	unsigned char tail[128]; /* last partial block plus padding and length */
+	size_t tailBlocks; /* blocks in tail */
+	size_t tailPos; /* next block in tail */
+	ssize_t job; /* index of message, -1 means lane is idle */
+} MD5_LANE;
+
+/*
+state is in lane-interleaved order, i.e. state[r * MD5_LANES + lane], and
+words is in same order, so both can be loaded directly as vectors.
+*/
+static void MD5TransformLanes(UINT4* state, const UINT4* words) {
+	const VUINT4 ones = V_SET1(0xffffffff);
+	VUINT4 a = V_LOAD(state), b = V_LOAD(state + MD5_LANES);
+	VUINT4 c = V_LOAD(state + 2 * MD5_LANES), d = V_LOAD(state + 3 * MD5_LANES);
+	VUINT4 x[16];
+	for (int i = 0; i < 16; i++)
+		x[i] = V_LOAD(words + i * MD5_LANES);
+
+	/* Round 1 */
+	VFF (a, b, c, d, x[ 0], S11, 0xd76aa478); /* 1 */
+	VFF (d, a, b, c, x[ 1], S12, 0xe8c7b756); /* 2 */
+	VFF (c, d, a, b, x[ 2], S13, 0x242070db); /* 3 */
+	VFF (b, c, d, a, x[ 3], S14, 0xc1bdceee); /* 4 */
+	VFF (a, b, c, d, x[ 4], S11, 0xf57c0faf); /* 5 */
+	VFF (d, a, b, c, x[ 5], S12, 0x4787c62a); /* 6 */
+	VFF (c, d, a, b, x[ 6], S13, 0xa8304613); /* 7 */
+	VFF (b, c, d, a, x[ 7], S14, 0xfd469501); /* 8 */
+	VFF (a, b, c, d, x[ 8], S11, 0x698098d8); /* 9 */
+	VFF (d, a, b, c, x[ 9], S12, 0x8b44f7af); /* 10 */
+	VFF (c, d, a, b, x[10], S13, 0xffff5bb1); /* 11 */
+	VFF (b, c, d, a, x[11], S14, 0x895cd7be); /* 12 */
+	VFF (a, b, c, d, x[12], S11, 0x6b901122); /* 13 */
+	VFF (d, a, b, c, x[13], S12, 0xfd987193); /* 14 */
+	VFF (c, d, a, b, x[14], S13, 0xa679438e); /* 15 */
+	VFF (b, c, d, a, x[15], S14, 0x49b40821); /* 16 */
+
+	/* Round 2 */
+	VGG (a, b, c, d, x[ 1], S21, 0xf61e2562); /* 17 */
+	VGG (d, a, b, c, x[ 6], S22, 0xc040b340); /* 18 */
+	VGG (c, d, a, b, x[11], S23, 0x265e5a51); /* 19 */
+	VGG (b, c, d, a, x[ 0], S24, 0xe9b6c7aa); /* 20 */
+	VGG (a, b, c, d, x[ 5], S21, 0xd62f105d); /* 21 */
+	VGG (d, a, b, c, x[10], S22, 0x2441453); /* 22 */
+	VGG (c, d, a, b, x[15], S23, 0xd8a1e681); /* 23 */
+	VGG (b, c, d, a, x[ 4], S24, 0xe7d3fbc8); /* 24 */
+	VGG (a, b, c, d, x[ 9], S21, 0x21e1cde6); /* 25 */
+	VGG (d, a, b, c, x[14], S22, 0xc33707d6); /* 26 */
+	VGG (c, d, a, b, x[ 3], S23, 0xf4d50d87); /* 27 */
+	VGG (b, c, d, a, x[ 8], S24, 0x455a14ed); /* 28 */
+	VGG (a, b, c, d, x[13], S21, 0xa9e3e905); /* 29 */
+	VGG (d, a, b, c, x[ 2], S22, 0xfcefa3f8); /* 30 */
+	VGG (c, d, a, b, x[ 7], S23, 0x676f02d9); /* 31 */
+	VGG (b, c, d, a, x[12], S24, 0x8d2a4c8a); /* 32 */
+
+	/* Round 3 */
+	VHH (a, b, c, d, x[ 5], S31, 0xfffa3942); /* 33 */
+	VHH (d, a, b, c, x[ 8], S32, 0x8771f681); /* 34 */
+	VHH (c, d, a, b, x[11], S33, 0x6d9d6122); /* 35 */
+	VHH (b, c, d, a, x[14], S34, 0xfde5380c); /* 36 */
+	VHH (a, b, c, d, x[ 1], S31, 0xa4beea44); /* 37 */
+	VHH (d, a, b, c, x[ 4], S32, 0x4bdecfa9); /* 38 */
+	VHH (c, d, a, b, x[ 7], S33, 0xf6bb4b60); /* 39 */
+	VHH (b, c, d, a, x[10], S34, 0xbebfbc70); /* 40 */
+	VHH (a, b, c, d, x[13], S31, 0x289b7ec6); /* 41 */
+	VHH (d, a, b, c, x[ 0], S32, 0xeaa127fa); /* 42 */
+	VHH (c, d, a, b, x[ 3], S33, 0xd4ef3085); /* 43 */
+	VHH (b, c, d, a, x[ 6], S34, 0x4881d05); /* 44 */
+	VHH (a, b, c, d, x[ 9], S31, 0xd9d4d039); /* 45 */
+	VHH (d, a, b, c, x[12], S32, 0xe6db99e5); /* 46 */
+	VHH (c, d, a, b, x[15], S33, 0x1fa27cf8); /* 47 */
+	VHH (b, c, d, a, x[ 2], S34, 0xc4ac5665); /* 48 */
+
+	/* Round 4 */
+	VII (a, b, c, d, x[ 0], S41, 0xf4292244); /* 49 */
+	VII (d, a, b, c, x[ 7], S42, 0x432aff97); /* 50 */
+	VII (c, d, a, b, x[14], S43, 0xab9423a7); /* 51 */
+	VII (b, c, d, a, x[ 5], S44, 0xfc93a039); /* 52 */
+	VII (a, b, c, d, x[12], S41, 0x655b59c3); /* 53 */
+	VII (d, a, b, c, x[ 3], S42, 0x8f0ccc92); /* 54 */
+	VII (c, d, a, b, x[10], S43, 0xffeff47d); /* 55 */
+	VII (b, c, d, a, x[ 1], S44, 0x85845dd1); /* 56 */
+	VII (a, b, c, d, x[ 8], S41, 0x6fa87e4f); /* 57 */
+	VII (d, a, b, c, x[15], S42, 0xfe2ce6e0); /* 58 */
+	VII (c, d, a, b, x[ 6], S43, 0xa3014314); /* 59 */
+	VII (b, c, d, a, x[13], S44, 0x4e0811a1); /* 60 */
+	VII (a, b, c, d, x[ 4], S41, 0xf7537e82); /* 61 */
+	VII (d, a, b, c, x[11], S42, 0xbd3af235); /* 62 */
+	VII (c, d, a, b, x[ 2], S43, 0x2ad7d2bb); /* 63 */
+	VII (b, c, d, a, x[ 9], S44, 0xeb86d391); /* 64 */
+
+	V_STORE(state, V_ADD(V_LOAD(state), a));
+	V_STORE(state + MD5_LANES, V_ADD(V_LOAD(state + MD5_LANES), b));
+	V_STORE(state + 2 * MD5_LANES, V_ADD(V_LOAD(state + 2 * MD5_LANES), c));
+	V_STORE(state + 3 * MD5_LANES, V_ADD(V_LOAD(state + 3 * MD5_LANES), d));
+}
+
+static void MD5LaneStart(MD5_LANE* lane, UINT4* state, int index, ssize_t job, const unsigned char* data, size_t len) {
+	size_t rem = len & 0x3f;
+	UINT4 bits[2];
+
+	lane->job = job;
+	lane->data = data;
+	lane->blocks = len >> 6;
+	lane->tailPos = 0;
+	lane->tailBlocks = (rem < 56) ? 1 : 2;
+
+	/* build last block(s): remaining bytes, padding and length */
+	if (rem > 0)
+		memcpy(lane->tail, data + (len - rem), rem);
+	memset(lane->tail + rem, 0, lane->tailBlocks * 64 - rem);
+	lane->tail[rem] = 0x80;
+	bits[0] = (UINT4)(len << 3);
+	bits[1] = (UINT4)((uint64_t)len >> 29);
+	Encode(lane->tail + lane->tailBlocks * 64 - 8, bits, 8);
+
+	state[index] = 0x67452301;
+	state[MD5_LANES + index] = 0xefcdab89;
+	state[2 * MD5_LANES + index] = 0x98badcfe;
+	state[3 * MD5_LANES + index] = 0x10325476;
+}
+
+static void MD5Lanes(const void* const* data, const size_t* len, size_t count, unsigned char (*digests)[16]) {
+	static const unsigned char ZERO_BLOCK[64] = { 0 };
+	MD5_LANE lanes[MD5_LANES];
+	UINT4 state[4 * MD5_LANES];
+	UINT4 words[16 * MD5_LANES];
+	UINT4 block[16];
+	size_t next = 0;
+	int active = 0;
+
+	/* fill lanes */
+	for (int i = 0; i < MD5_LANES; i++) {
+		if (next < count) {
+			MD5LaneStart(&lanes[i], state, i, next, (const unsigned char*)data[next], len[next]);
+			next++;
+			active++;
+		} else {
+			lanes[i].job = -1;
+		}
+	}
+
+	while (active > 0) {
+		/* gather one block from each lane, transposed */
+		for (int i = 0; i < MD5_LANES; i++) {
+			MD5_LANE* lane = &lanes[i];
+			const unsigned char* p;
+			if (lane->job < 0) {
+				p = ZERO_BLOCK;
+			} else if (lane->blocks > 0) {
+				p = lane->data;
+				lane->data += 64;
+				lane->blocks--;
+			} else {
+				p = lane->tail + 64 * lane->tailPos++;
+			}
+			Decode(block, p, 64);
+			for (int w = 0; w < 16; w++)
+				words[w * MD5_LANES + i] = block[w];
+		}
+
+		MD5TransformLanes(state, words);
+
+		/* output finished lanes and refill them */
+		for (int i = 0; i < MD5_LANES; i++) {
+			MD5_LANE* lane = &lanes[i];
+			if (lane->job < 0 || lane->blocks > 0 || lane->tailPos < lane->tailBlocks)
+				continue;
+
+			UINT4 s[4] = {
+				state[i], state[MD5_LANES + i], state[2 * MD5_LANES + i], state[3 * MD5_LANES + i]
+			};
+			Encode(digests[lane->job], s, 16);
+
+			if (next < count) {
+				MD5LaneStart(lane, state, i, next, (const unsigned char*)data[next], len[next]);
+				next++;
+			} else {
+				lane->job = -1;
+				active--;
+			}
+		}
+	}
+}
+
+#endif // #ifdef MD5_LANES
+
+static void DigestToHex(const unsigned char digest[16], char* hex) {
+	for (int i = 0; i < 16; i++) {
+		hex[2 * i] = HEX_DIGITS[digest[i] >> 4];
+		hex[2 * i + 1] = HEX_DIGITS[digest[i] & 0x0f];
+	}
+	hex[32] = 0;
 }
 
 const char* CCMD5::md5(const char* s) {
-	char* buffer = (char*)calloc(33, sizeof(char));
+	return md5(s, strlen(s));
+}
+
+const char* CCMD5::md5(const void* data, size_t len) {
+	char* buffer = (char*)malloc(33 * sizeof(char));
+	md5(data, len, buffer);
+	return (const char*)buffer;
+}
 
-	// update md5
+void CCMD5::md5(const void* data, size_t len, char hex[33]) {
 	unsigned char digest[16];
 	MD5_CTX context;
 	MD5Init(&context);
-	MD5Update(&context, (unsigned char*)s, strlen(s));
+	MD5Update(&context, (const unsigned char*)data, len);
 	MD5Final(digest, &context);
+	DigestToHex(digest, hex);
+}
 
-	// output as string
-	for (int i = 0; i < 16; i++) {
-		sprintf(&(buffer[2 * i]), "%02x", (unsigned char)digest[i]);
-	}
+void CCMD5::init(ccMD5Context* context) {
+	MD5Init(context);
+}
+
+void CCMD5::update(ccMD5Context* context, const void* data, size_t len) {
+	MD5Update(context, (const unsigned char*)data, len);
+}
 
+void CCMD5::final(ccMD5Context* context, unsigned char digest[16]) {
+	MD5Final(digest, context);
+}
+
+const char* CCMD5::toHex(const unsigned char digest[16]) {
+	char* buffer = (char*)malloc(33 * sizeof(char));
+	DigestToHex(digest, buffer);
 	return (const char*)buffer;
 }
 
-const char* CCMD5::md5(const void* data, size_t len) {
-	char* buffer = (char*)calloc(33, sizeof(char));
+void CCMD5::toHex(const unsigned char digest[16], char hex[33]) {
+	DigestToHex(digest, hex);
+}
 
-	// update md5
-	unsigned char digest[16];
+bool CCMD5::md5Stream(CCAssetInputStream* is, unsigned char digest[16]) {
+	if(!is)
+		return false;
+	
+	// read chunk by chunk
+	char* buf = (char*)malloc(MD5_CHUNK_SIZE);
 	MD5_CTX context;
 	MD5Init(&context);
-	MD5Update(&context, (unsigned char*)data, len);
+	ssize_t readBytes;
+	while((readBytes = is->read(buf, MD5_CHUNK_SIZE)) > 0) {
+		MD5Update(&context, (unsigned char*)buf, readBytes);
+	}
+	free(buf);
+	
+	// -1 means error
+	if(readBytes < 0) {
+		memset(&context, 0, sizeof(context));
+		return false;
+	}
+	
 	MD5Final(digest, &context);
+	return true;
+}
 
-	// output as string
-	for (int i = 0; i < 16; i++) {
-		sprintf(&(buffer[2 * i]), "%02x", (unsigned char)digest[i]);
+bool CCMD5::md5File(const string& path, unsigned char digest[16]) {
+	// try local file first, so data is streamed from disk
+	string localPath = CCUtils::mapLocalPath(path);
+	FILE* fp = localPath.empty() ? NULL : fopen(localPath.c_str(), "rb");
+	if(fp) {
+		char* buf = (char*)malloc(MD5_CHUNK_SIZE);
+		MD5_CTX context;
+		MD5Init(&context);
+		size_t readBytes;
+		while((readBytes = fread(buf, 1, MD5_CHUNK_SIZE, fp)) > 0) {
+			MD5Update(&context, (unsigned char*)buf, readBytes);
+		}
+		bool success = !ferror(fp);
+		fclose(fp);
+		free(buf);
+		
+		if(success)
+			MD5Final(digest, &context);
+		return success;
 	}
+	
+	// not a local file, it may be in apk
+	CCAssetInputStream* is = CCAssetInputStream::create(path);
+	if(!is->open())
+		return false;
+	bool success = md5Stream(is, digest);
+	is->close();
+	return success;
+}
 
-	return (const char*)buffer;
+const char* CCMD5::md5File(const string& path) {
+	unsigned char digest[16];
+	if(!md5File(path, digest))
+		return NULL;
+	return toHex(digest);
+}
+
+void CCMD5::md5Batch(const void* const* data, const size_t* len, size_t count, unsigned char (*digests)[16]) {
+#ifdef MD5_LANES
+	// one message doesn't benefit from lanes
+	if(count > 1) {
+		MD5Lanes(data, len, count, digests);
+		return;
+	}
+#endif
+	
+	// scalar fallback
+	for(size_t i = 0; i < count; i++) {
+		MD5_CTX context;
+		MD5Init(&context);
+		MD5Update(&context, (const unsigned char*)data[i], len[i]);
+		MD5Final(digests[i], &context);
+	}
 }
 
 #ifdef __cplusplus
@@ -0,0 +1,193 @@
+/****************************************************************************
+ Author: Luma (stubma@gmail.com)
+ 
+ https://github.com/stubma/cocos2dx-common
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ ****************************************************************************/
+#include "CCMD5Verifier.h"
+#include "CCMD5.h"
+#include "CCUtils.h"
+#include "CCCpuInfo.h"
+#include <stdio.h>
+#include <sys/stat.h>
+#if CC_TARGET_PLATFORM == CC_PLATFORM_WIN32
+	#include <windows.h>
+	#define strcasecmp _stricmp
+#else
+	#include <unistd.h>
+	#include <strings.h>
+#endif
+
+NS_CC_BEGIN
+
+/// read buffer size of every worker
+#define VERIFY_BUFFER_SIZE (256 * 1024)
+
+CCMD5Verifier::CCMD5Verifier(CCMD5VerifierListener* listener) :
+		m_listener(listener),
+		m_next(0),
+		m_failed(0),
+		m_cancelled(false) {
+	pthread_mutex_init(&m_mutex, NULL);
+	pthread_mutex_init(&m_cancelMutex, NULL);
+}
+
+CCMD5Verifier::~CCMD5Verifier() {
+	pthread_mutex_destroy(&m_mutex);
+	pthread_mutex_destroy(&m_cancelMutex);
+}
+
+CCMD5Verifier* CCMD5Verifier::create(CCMD5VerifierListener* listener) {
+	CCMD5Verifier* v = new CCMD5Verifier(listener);
+	return (CCMD5Verifier*)v->autorelease();
+}
+
+void CCMD5Verifier::addEntry(const string& path, int64_t size, const string& md5) {
+	Entry e;
+	e.path = path;
+	e.localPath = CCUtils::mapLocalPath(path);
+	e.size = size;
+	e.md5 = md5;
+	m_entries.push_back(e);
+}
+
+void CCMD5Verifier::removeAllEntries() {
+	m_entries.clear();
+}
+
+bool CCMD5Verifier::verify(int threads) {
+	// reset
+	m_next = 0;
+	m_failed = 0;
+	pthread_mutex_lock(&m_cancelMutex);
+	m_cancelled = false;
+	pthread_mutex_unlock(&m_cancelMutex);
+	if(m_entries.empty())
+		return true;
+	
+	// thread count, no more than files
+	if(threads <= 0)
+		threads = CCCpuInfo::getRecommendedWorkerCount();
+	if((size_t)threads > m_entries.size())
+		threads = (int)m_entries.size();
+	
+	// start workers, current thread is also a worker
+	vector<pthread_t> workers;
+	for(int i = 1; i < threads; i++) {
+		pthread_t t;
+		if(pthread_create(&t, NULL, workerThread, this) == 0) {
+			workers.push_back(t);
+		} else {
+			CCLOGWARN("CCMD5Verifier::verify: failed to create worker thread");
+			break;
+		}
+	}
+	workerThread(this);
+	
+	// wait
+	for(vector<pthread_t>::iterator iter = workers.begin(); iter != workers.end(); iter++) {
+		pthread_join(*iter, NULL);
+	}
+	
+	return m_failed == 0 && !isCancelled();
+}
+
+void CCMD5Verifier::cancel() {
+	pthread_mutex_lock(&m_cancelMutex);
+	m_cancelled = true;
+	pthread_mutex_unlock(&m_cancelMutex);
+}
+
+bool CCMD5Verifier::isCancelled() {
+	pthread_mutex_lock(&m_cancelMutex);
+	bool cancelled = m_cancelled;
+	pthread_mutex_unlock(&m_cancelMutex);
+	return cancelled;
+}
+
+void* CCMD5Verifier::workerThread(void* arg) {
+	CCMD5Verifier* v = (CCMD5Verifier*)arg;
+	char* buffer = (char*)malloc(VERIFY_BUFFER_SIZE);
+	
+	while(!v->isCancelled()) {
+		// get next entry
+		pthread_mutex_lock(&v->m_mutex);
+		size_t index = v->m_next++;
+		pthread_mutex_unlock(&v->m_mutex);
+		if(index >= v->m_entries.size())
+			break;
+		
+		// verify
+		const Entry& e = v->m_entries[index];
+		int result = v->verifyEntry(e, buffer, VERIFY_BUFFER_SIZE);
+		
+		// report
+		pthread_mutex_lock(&v->m_mutex);
+		if(result != OK)
+			v->m_failed++;
+		if(v->m_listener)
+			v->m_listener->onFileVerified(v, e.path, result);
+		pthread_mutex_unlock(&v->m_mutex);
+	}
+	
+	free(buffer);
+	return NULL;
+}
+
+int CCMD5Verifier::verifyEntry(const Entry& e, char* buffer, size_t bufferSize) {
+	FILE* fp = e.localPath.empty() ? NULL : fopen(e.localPath.c_str(), "rb");
+	if(!fp)
+		return MISSING;
+	
+	// check size first, it is cheap
+	struct stat st;
+	if(fstat(fileno(fp), &st) != 0) {
+		fclose(fp);
+		return MISSING;
+	}
+	if(e.size >= 0 && (int64_t)st.st_size != e.size) {
+		fclose(fp);
+		return SIZE_MISMATCH;
+	}
+	
+	// we read in big chunks, so stdio buffer is useless
+	setvbuf(fp, NULL, _IONBF, 0);
+	
+	// hash
+	ccMD5Context context;
+	CCMD5::init(&context);
+	size_t readBytes;
+	while((readBytes = fread(buffer, 1, bufferSize, fp)) > 0) {
+		CCMD5::update(&context, buffer, readBytes);
+	}
+	bool error = ferror(fp) != 0;
+	fclose(fp);
+	unsigned char digest[16];
+	CCMD5::final(&context, digest);
+	if(error)
+		return MISSING;
+	
+	// compare
+	char hex[33];
+	CCMD5::toHex(digest, hex);
+	return strcasecmp(hex, e.md5.c_str()) ? MD5_MISMATCH : OK;
+}
+
+NS_CC_END
@@ -0,0 +1,141 @@
+/****************************************************************************
+ Author: Luma (stubma@gmail.com)
+ 
+ https://github.com/stubma/cocos2dx-common
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ ****************************************************************************/
+#include "CCNodeIndex.h"
+
+NS_CC_BEGIN
+
+CCNodeIndex::CCNodeIndex(CCNode* root) :
+		m_root(root),
+		m_dirty(true),
+		m_autoValidate(true) {
+	CC_SAFE_RETAIN(m_root);
+}
+
+CCNodeIndex::~CCNodeIndex() {
+	clear();
+	CC_SAFE_RELEASE(m_root);
+}
+
+CCNodeIndex* CCNodeIndex::create(CCNode* root) {
+	CCNodeIndex* i = new CCNodeIndex(root);
+	return (CCNodeIndex*)i->autorelease();
+}
+
+void CCNodeIndex::clear() {
+	for(vector<CCNode*>::iterator iter = m_nodes.begin(); iter != m_nodes.end(); iter++) {
+		(*iter)->release();
+	}
+	m_nodes.clear();
+	m_rgbaNodes.clear();
+}
+
+void CCNodeIndex::rebuild() {
+	clear();
+	if(m_root)
+		collect(m_root);
+	m_dirty = false;
+}
+
+void CCNodeIndex::collect(CCNode* n) {
+	n->retain();
+	m_nodes.push_back(n);
+	CCRGBAProtocol* p = dynamic_cast<CCRGBAProtocol*>(n);
+	if(p) {
+		m_rgbaNodes.push_back(p);
+	}
+	
+	CCArray* children = n->getChildren();
+	int cc = n->getChildrenCount();
+	for(int i = 0; i < cc; i++) {
+		collect((CCNode*)children->objectAtIndex(i));
+	}
+}
+
+bool CCNodeIndex::matches(CCNode* n, size_t& pos) {
+	if(pos >= m_nodes.size() || m_nodes[pos] != n)
+		return false;
+	pos++;
+	
+	CCArray* children = n->getChildren();
+	int cc = n->getChildrenCount();
+	for(int i = 0; i < cc; i++) {
+		if(!matches((CCNode*)children->objectAtIndex(i), pos))
+			return false;
+	}
+	return true;
+}
+
+void CCNodeIndex::ensureValid() {
+	if(!m_dirty && m_autoValidate && m_root) {
+		size_t pos = 0;
+		m_dirty = !matches(m_root, pos) || pos != m_nodes.size();
+	}
+	if(m_dirty) {
+		rebuild();
+	}
+}
+
+void CCNodeIndex::setOpacity(GLubyte o) {
+	ensureValid();
+	size_t count = m_rgbaNodes.size();
+	CCRGBAProtocol** nodes = count > 0 ? &m_rgbaNodes[0] : NULL;
+	for(size_t i = 0; i < count; i++) {
+		nodes[i]->setOpacity(o);
+	}
+}
+
+void CCNodeIndex::setColor(const ccColor3B& c) {
+	ensureValid();
+	size_t count = m_rgbaNodes.size();
+	CCRGBAProtocol** nodes = count > 0 ? &m_rgbaNodes[0] : NULL;
+	for(size_t i = 0; i < count; i++) {
+		nodes[i]->setColor(c);
+	}
+}
+
+void CCNodeIndex::setVisible(bool v) {
+	ensureValid();
+	size_t count = m_nodes.size();
+	CCNode** nodes = count > 0 ? &m_nodes[0] : NULL;
+	for(size_t i = 0; i < count; i++) {
+		nodes[i]->setVisible(v);
+	}
+}
+
+size_t CCNodeIndex::getNodeCount() {
+	ensureValid();
+	return m_nodes.size();
+}
+
+size_t CCNodeIndex::getRGBANodeCount() {
+	ensureValid();
+	return m_rgbaNodes.size();
+}
+
+CCNode* CCNodeIndex::getNodeAt(size_t index) {
+	ensureValid();
+	return index < m_nodes.size() ? m_nodes[index] : NULL;
+}
+
+NS_CC_END
@@ -0,0 +1,202 @@
+/****************************************************************************
+ Author: Luma (stubma@gmail.com)
+ 
+ https://github.com/stubma/cocos2dx-common
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ ****************************************************************************/
+#include "CCPath.h"
+#include "CCUtils.h"
+#include "CCMoreMacros.h"
+#include <vector>
+
+/// is a char path separator, slash is always accepted
+#define IS_PATH_SEPARATOR(c) ((c) == '/' || (c) == CC_PATH_SEPARATOR)
+
+NS_CC_BEGIN
+
+CCPath::EntryMap CCPath::s_entries;
+pthread_mutex_t CCPath::s_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+CCPath::CCPath() :
+		m_entry(intern("")) {
+}
+
+CCPath::CCPath(const char* path) :
+		m_entry(intern(path ? path : "")) {
+}
+
+CCPath::CCPath(const string& path) :
+		m_entry(intern(path)) {
+}
+
+string CCPath::normalize(const string& path) {
+	const char* p = path.c_str();
+	size_t len = path.length();
+	bool absolute = len > 0 && IS_PATH_SEPARATOR(p[0]);
+	
+	// collect components as offset and length
+	vector<pair<size_t, size_t> > comps;
+	size_t i = 0;
+	while(i < len) {
+		while(i < len && IS_PATH_SEPARATOR(p[i]))
+			i++;
+		size_t start = i;
+		while(i < len && !IS_PATH_SEPARATOR(p[i]))
+			i++;
+		size_t n = i - start;
+		if(n == 0 || (n == 1 && p[start] == '.')) {
+			continue;
+		} else if(n == 2 && p[start] == '.' && p[start + 1] == '.') {
+			// pop last component if it is not "..", it can't go above root
+			if(!comps.empty()) {
+				const pair<size_t, size_t>& last = comps.back();
+				if(last.second != 2 || p[last.first] != '.' || p[last.first + 1] != '.') {
+					comps.pop_back();
+					continue;
+				}
+			}
+			if(absolute)
+				continue;
+		}
+		comps.push_back(make_pair(start, n));
+	}
+	
+	// join
+	string ret;
+	ret.reserve(len);
+	if(absolute)
+		ret.push_back(CC_PATH_SEPARATOR);
+	for(vector<pair<size_t, size_t> >::iterator iter = comps.begin(); iter != comps.end(); iter++) {
+		if(iter != comps.begin())
+			ret.push_back(CC_PATH_SEPARATOR);
+		ret.append(p + iter->first, iter->second);
+	}
+	return ret;
+}
+
+CCPath::Entry* CCPath::intern(const string& path) {
+	// fast path, path is already seen
+	pthread_mutex_lock(&s_mutex);
+	EntryMap::iterator iter = s_entries.find(path);
+	if(iter != s_entries.end()) {
+		Entry* e = iter->second;
+		pthread_mutex_unlock(&s_mutex);
+		return e;
+	}
+	pthread_mutex_unlock(&s_mutex);
+	
+	// normalize out of lock
+	string normalized = normalize(path);
+	
+	// find by normalized path, or create new entry
+	pthread_mutex_lock(&s_mutex);
+	Entry* e;
+	iter = s_entries.find(normalized);
+	if(iter != s_entries.end()) {
+		e = iter->second;
+	} else {
+		e = new Entry();
+		e->path = normalized;
+		e->parent = NULL;
+		e->mapped = false;
+		
+		// cache offsets
+		size_t slash = normalized.find_last_of(CC_PATH_SEPARATOR);
+		e->nameStart = slash == string::npos ? 0 : slash + 1;
+		size_t dot = normalized.rfind('.');
+		e->dot = (dot == string::npos || dot <= e->nameStart) ? string::npos : dot;
+		
+		s_entries[normalized] = e;
+	}
+	s_entries[path] = e;
+	pthread_mutex_unlock(&s_mutex);
+	
+	return e;
+}
+
+string CCPath::getLastPathComponent() const {
+	return m_entry->path.substr(m_entry->nameStart);
+}
+
+string CCPath::getPathExtension() const {
+	if(m_entry->dot == string::npos)
+		return "";
+	else
+		return m_entry->path.substr(m_entry->dot + 1);
+}
+
+string CCPath::deletePathExtension() const {
+	if(m_entry->dot == string::npos)
+		return m_entry->path;
+	else
+		return m_entry->path.substr(0, m_entry->dot);
+}
+
+CCPath CCPath::getParent() const {
+	pthread_mutex_lock(&s_mutex);
+	Entry* parent = m_entry->parent;
+	pthread_mutex_unlock(&s_mutex);
+	if(parent)
+		return CCPath(parent);
+	
+	// parent of root is root, parent of a single relative component is empty
+	const string& path = m_entry->path;
+	size_t end = m_entry->nameStart;
+	if(end > 1)
+		end--;
+	parent = intern(path.substr(0, end));
+	
+	pthread_mutex_lock(&s_mutex);
+	m_entry->parent = parent;
+	pthread_mutex_unlock(&s_mutex);
+	return CCPath(parent);
+}
+
+CCPath CCPath::append(const string& component) const {
+	return CCPath(CCUtils::appendPathComponent(m_entry->path, component));
+}
+
+string CCPath::getLocalPath() const {
+	// mapping which may change is done every time
+	const string* localPath = getFixedLocalPath();
+	return localPath ? *localPath : CCUtils::mapLocalPath(m_entry->path);
+}
+
+const string* CCPath::getFixedLocalPath() const {
+	if(!CCUtils::isLocalPathFixed(m_entry->path))
+		return NULL;
+	
+	// local path is never changed once it is mapped
+	pthread_mutex_lock(&s_mutex);
+	bool mapped = m_entry->mapped;
+	pthread_mutex_unlock(&s_mutex);
+	if(!mapped) {
+		string localPath = CCUtils::mapLocalPath(m_entry->path);
+		pthread_mutex_lock(&s_mutex);
+		if(!m_entry->mapped) {
+			m_entry->localPath = localPath;
+			m_entry->mapped = true;
+		}
+		pthread_mutex_unlock(&s_mutex);
+	}
+	return &m_entry->localPath;
+}
+
+NS_CC_END
@@ -28,6 +28,7 @@
  */
 #include "CCScroller.h"
 #include "CCUtils.h"
+#include "CCClock.h"
 
 NS_CC_BEGIN
 
@@ -63,7 +64,7 @@ CCScroller* CCScroller::create() {
 }
 
 int CCScroller::timePassed() const {
-	return (int)(CCUtils::currentTimeMillis() - m_startTime);
+	return (int)(CCClock::getFrameTimeMillis() - m_startTime);
 }
 
 bool CCScroller::computeScrollOffset() {
@@ -71,7 +72,7 @@ bool CCScroller::computeScrollOffset() {
 		return false;
 	}
 
-	int timePassed = (int) (CCUtils::currentTimeMillis() - m_startTime);
+	int timePassed = (int) (CCClock::getFrameTimeMillis() - m_startTime);
 
 	if(timePassed < m_duration) {
 		switch(m_mode) {
@@ -119,7 +120,7 @@ void CCScroller::startScroll(float startX, float startY, float dx, float dy, int
     m_mode = SCROLL_MODE;
     m_finished = false;
     m_duration = duration;
-    m_startTime = (int)CCUtils::currentTimeMillis();
+    m_startTime = CCClock::getFrameTimeMillis();
     m_startX = startX;
     m_startY = startY;
     m_finalX = startX + dx;
@@ -145,7 +146,7 @@ void CCScroller::fling(float startX, float startY, float velocityX, float veloci
 
     m_velocity = velocity;
     m_duration = (int) (1000 * velocity / m_deceleration);
-    m_startTime = CCUtils::currentTimeMillis();
+    m_startTime = CCClock::getFrameTimeMillis();
     m_startX = startX;
     m_startY = startY;
 
@@ -0,0 +1,215 @@
+/****************************************************************************
+ Author: Luma (stubma@gmail.com)
+ 
+ https://github.com/stubma/cocos2dx-common
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ ****************************************************************************/
+#include "CCSearchIndex.h"
+#include <limits.h>
+
+/// key count of a leaf block
+#define SEARCH_BLOCK_SIZE 16
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#include <emmintrin.h>
+	#define SEARCH_SSE2
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+	#include <arm_neon.h>
+	#define SEARCH_NEON
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+	#define SEARCH_PREFETCH(p) __builtin_prefetch(p)
+#elif defined(SEARCH_SSE2)
+	#define SEARCH_PREFETCH(p) _mm_prefetch((const char*)(p), _MM_HINT_T0)
+#else
+	#define SEARCH_PREFETCH(p)
+#endif
+
+NS_CC_BEGIN
+
+/// count of keys less than key in a block
+static inline int countLess(const int* block, int key) {
+#if defined(SEARCH_SSE2)
+	__m128i k = _mm_set1_epi32(key);
+	__m128i m0 = _mm_cmplt_epi32(_mm_loadu_si128((const __m128i*)block), k);
+	__m128i m1 = _mm_cmplt_epi32(_mm_loadu_si128((const __m128i*)(block + 4)), k);
+	__m128i m2 = _mm_cmplt_epi32(_mm_loadu_si128((const __m128i*)(block + 8)), k);
+	__m128i m3 = _mm_cmplt_epi32(_mm_loadu_si128((const __m128i*)(block + 12)), k);
+	
+	// every matched lane is -1, so sum of lanes is negative count
+	__m128i sum = _mm_add_epi32(_mm_add_epi32(m0, m1), _mm_add_epi32(m2, m3));
+	sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(1, 0, 3, 2)));
+	sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(2, 3, 0, 1)));
+	return -_mm_cvtsi128_si32(sum);
+#elif defined(SEARCH_NEON)
+	int32x4_t k = vdupq_n_s32(key);
+	uint32x4_t m0 = vcltq_s32(vld1q_s32(block), k);
+	uint32x4_t m1 = vcltq_s32(vld1q_s32(block + 4), k);
+	uint32x4_t m2 = vcltq_s32(vld1q_s32(block + 8), k);
+	uint32x4_t m3 = vcltq_s32(vld1q_s32(block + 12), k);
+	
+	// every matched lane is all ones, shift it to 1 and sum
+	uint32x4_t sum = vaddq_u32(vaddq_u32(vshrq_n_u32(m0, 31), vshrq_n_u32(m1, 31)),
+							   vaddq_u32(vshrq_n_u32(m2, 31), vshrq_n_u32(m3, 31)));
+	uint32x2_t half = vadd_u32(vget_low_u32(sum), vget_high_u32(sum));
+	return vget_lane_u32(vpadd_u32(half, half), 0);
+#else
+	int count = 0;
+	for(int i = 0; i < SEARCH_BLOCK_SIZE; i++) {
+		count += block[i] < key;
+	}
+	return count;
+#endif
+}
+
+/// count of trailing one bits
+static inline int trailingOnes(size_t k) {
+#if defined(__GNUC__) || defined(__clang__)
+	return __builtin_ctzll(~(unsigned long long)k);
+#else
+	int n = 0;
+	while(k & 1) {
+		k >>= 1;
+		n++;
+	}
+	return n;
+#endif
+}
+
+CCSearchIndex::CCSearchIndex() :
+		m_size(0) {
+}
+
+CCSearchIndex::CCSearchIndex(const int* sorted, size_t len) :
+		m_size(0) {
+	build(sorted, len);
+}
+
+size_t CCSearchIndex::buildTree(size_t k, size_t block, const vector<int>& maxKeys) {
+	if(k < m_tree.size()) {
+		block = buildTree(2 * k, block, maxKeys);
+		m_tree[k] = maxKeys[block];
+		m_blocks[k] = block;
+		block = buildTree(2 * k + 1, block + 1, maxKeys);
+	}
+	return block;
+}
+
+void CCSearchIndex::build(const int* sorted, size_t len) {
+	m_size = len;
+	
+	// keys padded with max int, it is never less than a key
+	size_t blockCount = (len + SEARCH_BLOCK_SIZE - 1) / SEARCH_BLOCK_SIZE;
+	m_keys.assign(sorted, sorted + len);
+	m_keys.resize(blockCount * SEARCH_BLOCK_SIZE, INT_MAX);
+	
+	// max key of blocks
+	vector<int> maxKeys(blockCount);
+	for(size_t i = 0; i < blockCount; i++) {
+		maxKeys[i] = sorted[MIN((i + 1) * SEARCH_BLOCK_SIZE, len) - 1];
+	}
+	
+	// tree, slot 0 is unused
+	m_tree.assign(blockCount + 1, 0);
+	m_blocks.assign(blockCount + 1, 0);
+	buildTree(1, 0, maxKeys);
+}
+
+size_t CCSearchIndex::lowerBound(int key) const {
+	if(m_size == 0)
+		return 0;
+	
+	// find first block whose max key is not less than key. Descendants of k four
+	// levels down are 16 adjacent nodes in one cache line, prefetch them ahead
+	size_t n = m_tree.size() - 1;
+	const int* tree = &m_tree[0];
+	size_t k = 1;
+	while(k <= n) {
+		SEARCH_PREFETCH(tree + MIN(k * 16, n));
+		k = 2 * k + (tree[k] < key);
+	}
+	k >>= trailingOnes(k) + 1;
+	if(k == 0)
+		return m_size;
+	
+	// count in block
+	size_t block = m_blocks[k];
+	return block * SEARCH_BLOCK_SIZE + countLess(&m_keys[block * SEARCH_BLOCK_SIZE], key);
+}
+
+int CCSearchIndex::search(int key) const {
+	size_t pos = lowerBound(key);
+	if(pos < m_size && m_keys[pos] == key)
+		return (int)pos;
+	else
+		return -((int)pos + 1);
+}
+
+void CCSearchIndex::search(const int* keys, size_t count, int* results) const {
+	if(m_size == 0) {
+		for(size_t i = 0; i < count; i++)
+			results[i] = -1;
+		return;
+	}
+	size_t n = m_tree.size() - 1;
+	
+	// descend four keys together, they have same depth because tree is complete
+	// except last level, so loads of different keys are issued back to back
+	const int* tree = &m_tree[0];
+	size_t i = 0;
+	for(; i + 4 <= count; i += 4) {
+		int k0 = keys[i], k1 = keys[i + 1], k2 = keys[i + 2], k3 = keys[i + 3];
+		size_t a = 1, b = 1, c = 1, d = 1;
+		while(a <= n && b <= n && c <= n && d <= n) {
+			a = 2 * a + (tree[a] < k0);
+			b = 2 * b + (tree[b] < k1);
+			c = 2 * c + (tree[c] < k2);
+			d = 2 * d + (tree[d] < k3);
+		}
+		while(a <= n)
+			a = 2 * a + (tree[a] < k0);
+		while(b <= n)
+			b = 2 * b + (tree[b] < k1);
+		while(c <= n)
+			c = 2 * c + (tree[c] < k2);
+		while(d <= n)
+			d = 2 * d + (tree[d] < k3);
+		
+		size_t nodes[4] = { a, b, c, d };
+		for(int j = 0; j < 4; j++) {
+			size_t k = nodes[j] >> (trailingOnes(nodes[j]) + 1);
+			size_t pos = m_size;
+			if(k != 0) {
+				size_t block = m_blocks[k];
+				pos = block * SEARCH_BLOCK_SIZE + countLess(&m_keys[block * SEARCH_BLOCK_SIZE], keys[i + j]);
+			}
+			if(pos < m_size && m_keys[pos] == keys[i + j])
+				results[i + j] = (int)pos;
+			else
+				results[i + j] = -((int)pos + 1);
+		}
+	}
+	for(; i < count; i++) {
+		results[i] = search(keys[i]);
+	}
+}
+
+NS_CC_END
@@ -0,0 +1,459 @@
+/****************************************************************************
+ Author: Luma (stubma@gmail.com)
+ 
+ https://github.com/stubma/cocos2dx-common
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ ****************************************************************************/
+#include "CCStringTable.h"
+#include "CCUtils.h"
+#include <algorithm>
+#if CC_TARGET_PLATFORM != CC_PLATFORM_WIN32
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <fcntl.h>
+	#include <unistd.h>
+#endif
+
+/// table magic
+#define TABLE_MAGIC "CCST"
+
+/// table version, also detects byte order
+#define TABLE_VERSION 1
+
+/// average key count in a bucket
+#define KEYS_PER_BUCKET 4
+
+/// max displacement tried for a bucket
+#define MAX_SEED (1 << 22)
+
+NS_CC_BEGIN
+
+/// table binary header, followed by seeds, slots and blob
+struct CCStringTable::Header {
+	char magic[4];
+	uint32_t version;
+	uint32_t count;
+	uint32_t bucketCount;
+	uint32_t blobLength;
+	uint32_t reserved;
+};
+
+/// a slot in table, indexed by perfect hash
+struct CCStringTable::Slot {
+	uint64_t hash;
+	uint32_t key;
+	uint32_t keyLength;
+	uint32_t value;
+	uint32_t valueLength;
+};
+
+/// murmur3 finalizer, spreads all bits of hash
+static inline uint64_t mix64(uint64_t h) {
+	h ^= h >> 33;
+	h *= 0xff51afd7ed558ccdULL;
+	h ^= h >> 33;
+	h *= 0xc4ceb9fe1a85ec53ULL;
+	h ^= h >> 33;
+	return h;
+}
+
+/// bucket of a key hash, high bits of FNV are poor for similar keys so mix it
+static inline uint32_t bucketOf(uint64_t h, uint32_t bucketCount) {
+	return (uint32_t)(mix64(h) >> 32) % bucketCount;
+}
+
+/// slot of a key hash with a displacement seed
+static inline uint32_t slotOf(uint64_t h, uint32_t seed, uint32_t count) {
+	return (uint32_t)(mix64(h ^ (seed * 0x9e3779b97f4a7c15ULL)) % count);
+}
+
+/// offset of slots after header (6 uint32) and seeds, aligned to 8 bytes
+static inline size_t slotsOffset(uint32_t bucketCount) {
+	return (sizeof(uint32_t) * 6 + sizeof(uint32_t) * bucketCount + 7) & ~(size_t)7;
+}
+
+CCStringTable::Builder::Builder() :
+		m_replaced(0) {
+}
+
+uint32_t CCStringTable::Builder::appendString(const char* s, size_t len) {
+	uint32_t offset = (uint32_t)m_blob.size();
+	m_blob.insert(m_blob.end(), s, s + len);
+	m_blob.push_back(0);
+	return offset;
+}
+
+bool CCStringTable::Builder::add(const char* key, size_t keyLength, const char* value, size_t valueLength) {
+	uint64_t h = CCStringTable::hash(key, keyLength);
+	map<uint64_t, size_t>::iterator iter = m_index.find(h);
+	if(iter != m_index.end()) {
+		// same hash must be same key
+		Entry& old = m_entries[iter->second];
+		if(old.keyLength != keyLength || memcmp(&m_blob[old.key], key, keyLength)) {
+			CCLOGERROR("CCStringTable::Builder::add: hash of key %.*s collides with %s", (int)keyLength, key, &m_blob[old.key]);
+			return false;
+		}
+		
+		// old one will be skipped
+		m_replaced++;
+	}
+	
+	Entry e;
+	e.hash = h;
+	e.keyLength = (uint32_t)keyLength;
+	e.key = appendString(key, keyLength);
+	e.valueLength = (uint32_t)valueLength;
+	e.value = appendString(value, valueLength);
+	m_index[h] = m_entries.size();
+	m_entries.push_back(e);
+	return true;
+}
+
+void CCStringTable::Builder::addTable(const CCStringTable& table) {
+	int count = (int)table.size();
+	for(int i = 0; i < count; i++) {
+		size_t keyLength, valueLength;
+		const char* key = table.keyAt(i, &keyLength);
+		const char* value = table.valueAt(i, &valueLength);
+		add(key, keyLength, value, valueLength);
+	}
+}
+
+void CCStringTable::Builder::addBuilder(const Builder& builder) {
+	for(size_t i = 0; i < builder.m_entries.size(); i++) {
+		// skip replaced one
+		const Entry& e = builder.m_entries[i];
+		if(builder.m_index.find(e.hash)->second != i)
+			continue;
+		add(&builder.m_blob[e.key], e.keyLength, &builder.m_blob[e.value], e.valueLength);
+	}
+}
+
+void CCStringTable::Builder::clear() {
+	m_blob.clear();
+	m_entries.clear();
+	m_index.clear();
+	m_replaced = 0;
+}
+
+/// bucket and its keys, used when searching displacement
+struct BucketKeys {
+	uint32_t bucket;
+	vector<uint64_t> hashes;
+	vector<size_t> entries;
+};
+
+/// bigger bucket first, they are harder to place
+static bool isBiggerBucket(const BucketKeys* a, const BucketKeys* b) {
+	return a->hashes.size() > b->hashes.size();
+}
+
+bool CCStringTable::Builder::compile(vector<char>& out) const {
+	uint32_t count = (uint32_t)size();
+	uint32_t bucketCount = MAX(1, (count + KEYS_PER_BUCKET - 1) / KEYS_PER_BUCKET);
+	
+	// distribute keys to buckets
+	vector<BucketKeys> buckets(bucketCount);
+	for(uint32_t i = 0; i < bucketCount; i++) {
+		buckets[i].bucket = i;
+	}
+	for(size_t i = 0; i < m_entries.size(); i++) {
+		// skip replaced one
+		const Entry& e = m_entries[i];
+		if(m_index.find(e.hash)->second != i)
+			continue;
+		BucketKeys& b = buckets[bucketOf(e.hash, bucketCount)];
+		b.hashes.push_back(e.hash);
+		b.entries.push_back(i);
+	}
+	vector<BucketKeys*> order(bucketCount);
+	for(uint32_t i = 0; i < bucketCount; i++) {
+		order[i] = &buckets[i];
+	}
+	stable_sort(order.begin(), order.end(), isBiggerBucket);
+	
+	// find displacement of every bucket so that its keys fall to free slots
+	vector<uint32_t> seeds(bucketCount, 0);
+	vector<int> slotEntries(count, -1);
+	vector<uint32_t> tried;
+	for(uint32_t i = 0; i < bucketCount && !order[i]->hashes.empty(); i++) {
+		BucketKeys& b = *order[i];
+		size_t n = b.hashes.size();
+		uint32_t seed = 0;
+		for(; seed < MAX_SEED; seed++) {
+			tried.clear();
+			size_t k = 0;
+			for(; k < n; k++) {
+				uint32_t slot = slotOf(b.hashes[k], seed, count);
+				if(slotEntries[slot] != -1 || find(tried.begin(), tried.end(), slot) != tried.end())
+					break;
+				tried.push_back(slot);
+			}
+			if(k == n)
+				break;
+		}
+		if(seed == MAX_SEED) {
+			CCLOGERROR("CCStringTable::Builder::compile: failed to find perfect hash for %u keys", count);
+			return false;
+		}
+		seeds[b.bucket] = seed;
+		for(size_t k = 0; k < n; k++) {
+			slotEntries[tried[k]] = (int)b.entries[k];
+		}
+	}
+	
+	// write header, seeds, slots, then blob with only live strings
+	size_t slotStart = slotsOffset(bucketCount);
+	size_t blobStart = slotStart + sizeof(Slot) * count;
+	out.assign(blobStart, 0);
+	out.reserve(blobStart + m_blob.size());
+	Header* header = (Header*)&out[0];
+	memcpy(header->magic, TABLE_MAGIC, 4);
+	header->version = TABLE_VERSION;
+	header->count = count;
+	header->bucketCount = bucketCount;
+	memcpy(&out[sizeof(Header)], &seeds[0], sizeof(uint32_t) * bucketCount);
+	for(uint32_t i = 0; i < count; i++) {
+		const Entry& e = m_entries[slotEntries[i]];
+		Slot s;
+		s.hash = e.hash;
+		s.keyLength = e.keyLength;
+		s.valueLength = e.valueLength;
+		s.key = (uint32_t)(out.size() - blobStart);
+		out.insert(out.end(), m_blob.begin() + e.key, m_blob.begin() + e.key + e.keyLength + 1);
+		s.value = (uint32_t)(out.size() - blobStart);
+		out.insert(out.end(), m_blob.begin() + e.value, m_blob.begin() + e.value + e.valueLength + 1);
+		memcpy(&out[slotStart + sizeof(Slot) * i], &s, sizeof(Slot));
+	}
+	((Header*)&out[0])->blobLength = (uint32_t)(out.size() - blobStart);
+	return true;
+}
+
+CCStringTable::CCStringTable() :
+		m_mapped(NULL),
+		m_mappedLength(0),
+		m_header(NULL),
+		m_seeds(NULL),
+		m_slots(NULL),
+		m_blob(NULL) {
+}
+
+CCStringTable::~CCStringTable() {
+	unload();
+}
+
+uint64_t CCStringTable::hash(const char* key, size_t len, uint64_t seed) {
+	uint64_t h = seed;
+	for(size_t i = 0; i < len; i++) {
+		h ^= (unsigned char)key[i];
+		h *= 0x100000001b3ULL;
+	}
+	return h;
+}
+
+bool CCStringTable::attach(const char* data, size_t length) {
+	// check header
+	const Header* header = (const Header*)data;
+	if(length < sizeof(Header) || memcmp(header->magic, TABLE_MAGIC, 4)) {
+		CCLOGWARN("CCStringTable: data is not a string table");
+		return false;
+	}
+	if(header->version != TABLE_VERSION) {
+		CCLOGWARN("CCStringTable: unsupported version or byte order");
+		return false;
+	}
+	size_t slotStart = slotsOffset(header->bucketCount);
+	size_t blobStart = slotStart + sizeof(Slot) * (size_t)header->count;
+	if(header->bucketCount == 0 || blobStart + header->blobLength > length) {
+		CCLOGWARN("CCStringTable: table data is truncated");
+		return false;
+	}
+	
+	// every string must be in blob and zero terminated
+	const Slot* slots = (const Slot*)(data + slotStart);
+	const char* blob = data + blobStart;
+	uint32_t blobLength = header->blobLength;
+	for(uint32_t i = 0; i < header->count; i++) {
+		const Slot& s = slots[i];
+		if((uint64_t)s.key + s.keyLength >= blobLength || (uint64_t)s.value + s.valueLength >= blobLength ||
+		   blob[s.key + s.keyLength] || blob[s.value + s.valueLength]) {
+			CCLOGWARN("CCStringTable: table data is corrupted");
+			return false;
+		}
+	}
+	
+	m_header = header;
+	m_seeds = (const uint32_t*)(data + sizeof(Header));
+	m_slots = slots;
+	m_blob = blob;
+	return true;
+}
+
+bool CCStringTable::build(const Builder& builder) {
+	vector<char> data;
+	if(!builder.compile(data))
+		return false;
+	return loadData(data);
+}
+
+bool CCStringTable::loadData(vector<char>& data) {
+	unload();
+	m_owned.swap(data);
+	if(m_owned.empty() || !attach(&m_owned[0], m_owned.size())) {
+		unload();
+		return false;
+	}
+	return true;
+}
+
+bool CCStringTable::mapFile(const string& path) {
+	unload();
+	
+#if CC_TARGET_PLATFORM != CC_PLATFORM_WIN32
+	// only real file can be mapped
+	string localPath = CCUtils::mapLocalPath(path);
+	int fd = open(localPath.c_str(), O_RDONLY);
+	if(fd != -1) {
+		struct stat st;
+		void* addr = MAP_FAILED;
+		if(!fstat(fd, &st) && st.st_size > 0) {
+			addr = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		}
+		close(fd);
+		if(addr != MAP_FAILED) {
+			m_mapped = addr;
+			m_mappedLength = (size_t)st.st_size;
+			if(!attach((const char*)addr, m_mappedLength)) {
+				unload();
+				return false;
+			}
+			return true;
+		}
+	}
+#endif
+	
+	return false;
+}
+
+bool CCStringTable::loadFile(const string& path) {
+	// map it if it is a real file
+	if(mapFile(path))
+		return true;
+	
+	// file may be in apk, read it
+	string localPath = CCUtils::mapLocalPath(path);
+	unsigned long size = 0;
+	unsigned char* buf = CCFileUtils::sharedFileUtils()->getFileData(localPath.c_str(), "rb", &size);
+	if(!buf) {
+		CCLOGWARN("CCStringTable::loadFile: can't read %s", path.c_str());
+		return false;
+	}
+	vector<char> data(buf, buf + size);
+	free(buf);
+	return loadData(data);
+}
+
+bool CCStringTable::save(const string& path) const {
+	if(!m_header) {
+		CCLOGWARN("CCStringTable::save: table is empty");
+		return false;
+	}
+	
+	string localPath = CCUtils::mapLocalPath(path);
+	CCUtils::createIntermediateFolders(localPath);
+	FILE* f = fopen(localPath.c_str(), "wb");
+	if(!f) {
+		CCLOGWARN("CCStringTable::save: can't open %s", path.c_str());
+		return false;
+	}
+	size_t length = (m_blob - (const char*)m_header) + m_header->blobLength;
+	bool ok = fwrite(m_header, 1, length, f) == length;
+	fclose(f);
+	return ok;
+}
+
+void CCStringTable::unload() {
+#if CC_TARGET_PLATFORM != CC_PLATFORM_WIN32
+	if(m_mapped) {
+		munmap(m_mapped, m_mappedLength);
+	}
+#endif
+	m_mapped = NULL;
+	m_mappedLength = 0;
+	vector<char>().swap(m_owned);
+	m_header = NULL;
+	m_seeds = NULL;
+	m_slots = NULL;
+	m_blob = NULL;
+}
+
+void CCStringTable::swap(CCStringTable& t) {
+	// owned data buffer keeps its address after swapping
+	m_owned.swap(t.m_owned);
+	std::swap(m_mapped, t.m_mapped);
+	std::swap(m_mappedLength, t.m_mappedLength);
+	std::swap(m_header, t.m_header);
+	std::swap(m_seeds, t.m_seeds);
+	std::swap(m_slots, t.m_slots);
+	std::swap(m_blob, t.m_blob);
+}
+
+size_t CCStringTable::size() const {
+	return m_header ? m_header->count : 0;
+}
+
+int CCStringTable::indexOfHash(uint64_t h) const {
+	if(!m_header || m_header->count == 0)
+		return -1;
+	uint32_t seed = m_seeds[bucketOf(h, m_header->bucketCount)];
+	uint32_t slot = slotOf(h, seed, m_header->count);
+	return m_slots[slot].hash == h ? (int)slot : -1;
+}
+
+int CCStringTable::indexOf(const char* key, size_t len) const {
+	int index = indexOfHash(hash(key, len));
+	if(index != -1) {
+		const Slot& s = m_slots[index];
+		if(s.keyLength != len || memcmp(m_blob + s.key, key, len))
+			return -1;
+	}
+	return index;
+}
+
+const char* CCStringTable::keyAt(int index, size_t* len) const {
+	const Slot& s = m_slots[index];
+	if(len)
+		*len = s.keyLength;
+	return m_blob + s.key;
+}
+
+const char* CCStringTable::valueAt(int index, size_t* len) const {
+	const Slot& s = m_slots[index];
+	if(len)
+		*len = s.valueLength;
+	return m_blob + s.value;
+}
+
+const char* CCStringTable::lookup(const char* key, size_t len, size_t* valueLength) const {
+	int index = indexOf(key, len);
+	return index == -1 ? NULL : valueAt(index, valueLength);
+}
+
+NS_CC_END
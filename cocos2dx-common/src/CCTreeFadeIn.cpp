@@ -26,6 +26,14 @@
 
 NS_CC_BEGIN
 
+CCTreeFadeIn::CCTreeFadeIn() :
+        m_index(NULL) {
+}
+
+CCTreeFadeIn::~CCTreeFadeIn() {
+    CC_SAFE_RELEASE(m_index);
+}
+
 CCTreeFadeIn* CCTreeFadeIn::create(float d) {
     CCTreeFadeIn* pAction = new CCTreeFadeIn();
     pAction->initWithDuration(d);
@@ -33,24 +41,28 @@ CCTreeFadeIn* CCTreeFadeIn::create(float d) {
     return pAction;
 }
 
-void CCTreeFadeIn::update(float time) {
-    CCFadeIn::update(time);
+void CCTreeFadeIn::startWithTarget(CCNode* pTarget) {
+    CCFadeIn::startWithTarget(pTarget);
     
-    fadeInRecursively(getTarget(), time);
+    // index target tree
+    CC_SAFE_RELEASE(m_index);
+    m_index = CCNodeIndex::create(pTarget);
+    m_index->retain();
 }
 
-void CCTreeFadeIn::fadeInRecursively(CCNode* n, float time) {
-    CCArray* children = n->getChildren();
-    int cc = n->getChildrenCount();
-    for(int i = 0; i < cc; i++) {
-        CCNode* child = (CCNode*)children->objectAtIndex(i);
-        CCRGBAProtocol* p = dynamic_cast<CCRGBAProtocol*>(child);
-        if(p) {
-            p->setOpacity((GLubyte)(255 * time));
-        }
-        
-        fadeInRecursively(child, time);
-    }
+void CCTreeFadeIn::stop() {
+    // release index so that nodes removed later are not kept alive by this action
+    CC_SAFE_RELEASE_NULL(m_index);
+    
+    CCFadeIn::stop();
+}
+
+void CCTreeFadeIn::update(float time) {
+    CCFadeIn::update(time);
+    
+    // index includes target itself, it gets same opacity again
+    if(m_index)
+        m_index->setOpacity((GLubyte)(255 * time));
 }
 
 CCActionInterval* CCTreeFadeIn::reverse(void) {
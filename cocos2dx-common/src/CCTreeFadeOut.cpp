@@ -26,6 +26,14 @@
 
 NS_CC_BEGIN
 
+CCTreeFadeOut::CCTreeFadeOut() :
+        m_index(NULL) {
+}
+
+CCTreeFadeOut::~CCTreeFadeOut() {
+    CC_SAFE_RELEASE(m_index);
+}
+
 CCTreeFadeOut* CCTreeFadeOut::create(float d) {
     CCTreeFadeOut* pAction = new CCTreeFadeOut();
     pAction->initWithDuration(d);
@@ -33,24 +41,28 @@ CCTreeFadeOut* CCTreeFadeOut::create(float d) {
     return pAction;
 }
 
-void CCTreeFadeOut::update(float time) {
-    CCFadeOut::update(time);
+void CCTreeFadeOut::startWithTarget(CCNode* pTarget) {
+    CCFadeOut::startWithTarget(pTarget);
     
-    fadeOutRecursively(getTarget(), time);
+    // index target tree
+    CC_SAFE_RELEASE(m_index);
+    m_index = CCNodeIndex::create(pTarget);
+    m_index->retain();
 }
 
-void CCTreeFadeOut::fadeOutRecursively(CCNode* n, float time) {
-    CCArray* children = n->getChildren();
-    int cc = n->getChildrenCount();
-    for(int i = 0; i < cc; i++) {
-        CCNode* child = (CCNode*)children->objectAtIndex(i);
-        CCRGBAProtocol* p = dynamic_cast<CCRGBAProtocol*>(child);
-        if(p) {
-            p->setOpacity((GLubyte)(255 * (1 - time)));
-        }
-        
-        fadeOutRecursively(child, time);
-    }
+void CCTreeFadeOut::stop() {
+    // release index so that nodes removed later are not kept alive by this action
+    CC_SAFE_RELEASE_NULL(m_index);
+    
+    CCFadeOut::stop();
+}
+
+void CCTreeFadeOut::update(float time) {
+    CCFadeOut::update(time);
+    
+    // index includes target itself, it gets same opacity again
+    if(m_index)
+        m_index->setOpacity((GLubyte)(255 * (1 - time)));
 }
 
 CCActionInterval* CCTreeFadeOut::reverse(void) {
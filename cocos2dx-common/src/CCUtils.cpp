@@ -24,17 +24,34 @@
 #include "CCUtils.h"
 #include "CCMoreMacros.h"
 #include "CCMD5.h"
+#include "CCCpuInfo.h"
 #if CC_TARGET_PLATFORM == CC_PLATFORM_IOS || CC_TARGET_PLATFORM == CC_PLATFORM_MAC
     #include <sys/sysctl.h>
 #elif CC_TARGET_PLATFORM == CC_PLATFORM_ANDROID
 	#include "JniHelper.h"
 #endif
+#if CC_TARGET_PLATFORM == CC_PLATFORM_ANDROID || CC_TARGET_PLATFORM == CC_PLATFORM_LINUX
+	#include <fcntl.h>
+	#include <errno.h>
+#endif
+
+#include <pthread.h>
+#include <locale.h>
+#include <float.h>
+#include <map>
+
+/// is a char path separator, slash is always accepted
+#define IS_PATH_SEPARATOR(c) ((c) == '/' || (c) == CC_PATH_SEPARATOR)
 
 NS_CC_BEGIN
 
 CCUtils::StringList CCUtils::s_tmpStringList;
 CCArray CCUtils::s_tmpArray;
 
+/// memo of mapped local path
+static map<string, string> s_localPathCache;
+static pthread_mutex_t s_localPathMutex = PTHREAD_MUTEX_INITIALIZER;
+
 unsigned char CCUtils::UnitScalarToByte(float x) {
     if (x < 0) {
         return 0;
@@ -125,20 +142,16 @@ ssize_t CCUtils::lastDotIndex(const string& path) {
 	return -1;
 }
 
-ssize_t CCUtils::lastSlashIndex(string path) {
+ssize_t CCUtils::lastSlashIndex(const string& path) {
 	if(path.empty())
 		return -1;
     
-	// change slash to windows format
-    if(CC_PATH_SEPARATOR != '/')
-        replaceChar(path, '/', CC_PATH_SEPARATOR);
-    
-	// find slash index
+	// find slash index, both slash and platform separator are accepted
 	size_t len = path.length();
 	int end = len;
 	int slash = -1;
 	for(int i = len - 1; i >= 0; i--) {
-		if(path[i] == CC_PATH_SEPARATOR) {
+		if(IS_PATH_SEPARATOR(path[i])) {
 			if(i == end - 1) {
 				end--;
 				if(i == 0) {
@@ -154,7 +167,7 @@ ssize_t CCUtils::lastSlashIndex(string path) {
     
 	// skip extra slash
 	if(slash != -1) {
-		while(slash >= 1 && path[slash - 1] == CC_PATH_SEPARATOR)
+		while(slash >= 1 && IS_PATH_SEPARATOR(path[slash - 1]))
 			slash--;
 	}
     
@@ -167,15 +180,11 @@ ssize_t CCUtils::lastSlashIndex(string path) {
 }
 
 string CCUtils::lastPathComponent(const string& path) {
-	// change slash to windows format
-	if(CC_PATH_SEPARATOR != '/')
-		replaceChar((string&)path, '/', CC_PATH_SEPARATOR);
-    
 	size_t len = path.length();
 	int start = 0;
 	int end = len;
 	for(int i = len - 1; i >= 0; i--) {
-		if(path[i] == CC_PATH_SEPARATOR) {
+		if(IS_PATH_SEPARATOR(path[i])) {
 			if(i == end - 1)
 				end--;
 			else {
@@ -188,7 +197,7 @@ string CCUtils::lastPathComponent(const string& path) {
 	if(end < start)
 		return path;
 	else
-		return path.substr(start, end);
+		return path.substr(start, end - start);
 }
 
 string CCUtils::deleteLastPathComponent(const string& path) {
@@ -200,62 +209,48 @@ string CCUtils::deleteLastPathComponent(const string& path) {
 }
 
 string CCUtils::appendPathComponent(const string& path, const string& component) {
-	// change slash to windows format
-	if(CC_PATH_SEPARATOR != '/')
-		replaceChar((string&)path, '/', CC_PATH_SEPARATOR);
-    
 	// validating
 	if(path.empty()) {
-		if(component.empty())
-			return "";
-		else
-			return component;
+		return component;
 	} else if(component.empty()) {
 		return path;
     }
     
-	// allocate a big enough buffer
-	// plus 2 because one for slash, one for null terminator
+	// keep only one trailing slash of path
 	size_t len = path.length();
-	int cLen = component.length();
-    char* buf = new char[len + cLen + 2];
-    memset(buf, 0, len + cLen + 2);
-    
-	// copy path
-	memcpy(buf, path.c_str(), len);
-    
-	// take care of slash
-	int start = len;
-	if(start > 0) {
-		if(buf[start - 1] != CC_PATH_SEPARATOR) {
-			buf[start++] = CC_PATH_SEPARATOR;
-		} else {
-			while(start >= 2 && buf[start - 2] == CC_PATH_SEPARATOR)
-				start--;
-		}
-	}
+	while(len >= 2 && IS_PATH_SEPARATOR(path[len - 1]) && IS_PATH_SEPARATOR(path[len - 2]))
+		len--;
     
-	// copy component
-	int cStart = 0;
-	while(cStart < cLen && component[cStart] == CC_PATH_SEPARATOR)
+	// skip leading and trailing slash of component
+	size_t cStart = 0;
+	size_t cEnd = component.length();
+	while(cStart < cEnd && IS_PATH_SEPARATOR(component[cStart]))
 		cStart++;
-	if(cStart > 0 && start == 0)
-		cStart--;
-	memcpy(buf + start, component.c_str() + cStart, cLen - cStart);
+	while(cEnd > cStart && IS_PATH_SEPARATOR(component[cEnd - 1]))
+		cEnd--;
+    
+	// build in one buffer
+	string ret;
+	ret.reserve(len + cEnd - cStart + 1);
+	ret.append(path, 0, len);
+	if(!IS_PATH_SEPARATOR(ret[len - 1]))
+		ret.push_back(CC_PATH_SEPARATOR);
+	ret.append(component, cStart, cEnd - cStart);
     
     // remove end slash
-    int end = start + cLen - cStart - 1;
-    while(buf[end] == CC_PATH_SEPARATOR)
-        buf[end--] = 0;
+    while(ret.length() > 1 && IS_PATH_SEPARATOR(ret[ret.length() - 1]))
+        ret.erase(ret.length() - 1);
+    
+	// change slash to windows format
+	if(CC_PATH_SEPARATOR != '/')
+		replaceChar(ret, '/', CC_PATH_SEPARATOR);
     
-    string ret = buf;
-    delete buf;
 	return ret;
 }
 
 string CCUtils::deletePathExtension(const string& path) {
     ssize_t end = lastDotIndex(path);
-	ssize_t slash = lastSlashIndex((string&)path);
+	ssize_t slash = lastSlashIndex(path);
 	if(end >= 0) {
 		if(end > slash)
 			return path.substr(0, end);
@@ -274,18 +269,20 @@ bool CCUtils::deleteFile(string path) {
 	NSError* error = nil;
 	[fm removeItemAtPath:p error:&error];
 	return error == nil;
-#elif CC_TARGET_PLATFORM == CC_PLATFORM_ANDROID
-	return unlink(path.c_str()) == 0;
+#elif CC_TARGET_PLATFORM == CC_PLATFORM_ANDROID || CC_TARGET_PLATFORM == CC_PLATFORM_LINUX
+	string mappedPath = mapLocalPath(path);
+	return unlink(mappedPath.c_str()) == 0;
 #elif CC_TARGET_PLATFORM == CC_PLATFORM_WIN32
 	string mappedPath = mapLocalPath(path);
 	return DeleteFile(mappedPath.c_str()) != 0;
 #else
-	CCLOGERROR("CCUtils::mapLocalPath is not implemented for this platform, please finish it");
+	CCLOGERROR("CCUtils::deleteFile is not implemented for this platform, please finish it");
 	return false;
 #endif
 }
 
-string CCUtils::mapLocalPath(string path) {
+/// map a path without memo
+static string mapLocalPathNoCache(const string& path) {
 #if CC_TARGET_PLATFORM == CC_PLATFORM_IOS || CC_TARGET_PLATFORM == CC_PLATFORM_MAC
 	if(CCFileUtils::sharedFileUtils()->isAbsolutePath(path)) {
 		NSString* nsPath = [NSString stringWithFormat:@"~/Documents/%s", path.c_str()];
@@ -299,15 +296,66 @@ string CCUtils::mapLocalPath(string path) {
 		NSString* filenameWithoutExt = [filename stringByDeletingPathExtension];
 		NSString* dir = [relativePath stringByDeletingLastPathComponent];
 		NSString* path = [bundle pathForResource:filenameWithoutExt ofType:ext inDirectory:dir];
+		if(path == nil)
+			return "";
 		return [path cStringUsingEncoding:NSUTF8StringEncoding];
 	}
 #elif CC_TARGET_PLATFORM == CC_PLATFORM_ANDROID
 	return path;
+#elif CC_TARGET_PLATFORM == CC_PLATFORM_LINUX
+	// absolute path is used as it is, relative path is searched in resource folders
+	if(path.empty() || path[0] == '/')
+		return path;
+	else
+		return CCFileUtils::sharedFileUtils()->fullPathForFilename(path.c_str());
 #else
 	CCLOGERROR("CCUtils::mapLocalPath is not implemented for this platform, please finish it");
+	return path;
+#endif
+}
+
+bool CCUtils::isLocalPathFixed(const string& path) {
+#if CC_TARGET_PLATFORM == CC_PLATFORM_LINUX
+	// relative path depends on search paths and file existence
+	return !path.empty() && path[0] == '/';
+#else
+	return true;
 #endif
 }
 
+string CCUtils::mapLocalPath(const string& path) {
+#if CC_TARGET_PLATFORM == CC_PLATFORM_ANDROID
+	return path;
+#else
+	// only fixed mapping can be memoized
+	if(!isLocalPathFixed(path))
+		return mapLocalPathNoCache(path);
+	
+	// check memo first
+	pthread_mutex_lock(&s_localPathMutex);
+	map<string, string>::iterator iter = s_localPathCache.find(path);
+	if(iter != s_localPathCache.end()) {
+		string ret = iter->second;
+		pthread_mutex_unlock(&s_localPathMutex);
+		return ret;
+	}
+	pthread_mutex_unlock(&s_localPathMutex);
+	
+	// map it out of lock, it may be slow
+	string mapped = mapLocalPathNoCache(path);
+	pthread_mutex_lock(&s_localPathMutex);
+	s_localPathCache[path] = mapped;
+	pthread_mutex_unlock(&s_localPathMutex);
+	return mapped;
+#endif
+}
+
+void CCUtils::purgeLocalPathCache() {
+	pthread_mutex_lock(&s_localPathMutex);
+	s_localPathCache.clear();
+	pthread_mutex_unlock(&s_localPathMutex);
+}
+
 string CCUtils::getParentPath(string path) {
 	if(path.empty())
 		return "";
@@ -323,6 +371,60 @@ string CCUtils::getParentPath(string path) {
 
 bool CCUtils::createIntermediateFolders(string path) {
 	string parent = getParentPath(path);
+	if(parent.empty())
+		return true;
+	
+#if CC_TARGET_PLATFORM == CC_PLATFORM_IOS || CC_TARGET_PLATFORM == CC_PLATFORM_MAC
+	// file manager creates all levels in one call
+	if(isPathExistent(parent))
+		return true;
+	return createFolder(parent);
+#elif CC_TARGET_PLATFORM == CC_PLATFORM_ANDROID || CC_TARGET_PLATFORM == CC_PLATFORM_LINUX
+	// find deepest existing level from bottom, stat only needs search permission
+	// of ancestors, so it works below unreadable folders such as /data in Android
+	string mappedPath = mapLocalPath(parent);
+	vector<char> buf(mappedPath.begin(), mappedPath.end());
+	buf.push_back(0);
+	char* p = &buf[0];
+	
+	// end offset of every component
+	vector<size_t> ends;
+	for(size_t i = 0; p[i]; ) {
+		while(p[i] == '/')
+			i++;
+		if(!p[i])
+			break;
+		while(p[i] && p[i] != '/')
+			i++;
+		ends.push_back(i);
+	}
+	int level = (int)ends.size() - 1;
+	for(; level >= 0; level--) {
+		char c = p[ends[level]];
+		p[ends[level]] = 0;
+		struct stat st;
+		int ret = stat(p, &st);
+		p[ends[level]] = c;
+		if(ret == 0) {
+			if(!S_ISDIR(st.st_mode))
+				return false;
+			break;
+		} else if(errno != ENOENT) {
+			return false;
+		}
+	}
+	
+	// create missing levels
+	for(size_t i = level + 1; i < ends.size(); i++) {
+		char c = p[ends[i]];
+		p[ends[i]] = 0;
+		int ret = mkdir(p, S_IRWXU | S_IRGRP | S_IXGRP | S_IROTH | S_IXOTH);
+		p[ends[i]] = c;
+		if(ret != 0 && errno != EEXIST)
+			return false;
+	}
+	return true;
+#else
 	bool exist = isPathExistent(parent);
 	bool success = true;
 	if(!exist) {
@@ -332,6 +434,7 @@ bool CCUtils::createIntermediateFolders(string path) {
 	
 	// return success flag
 	return success;
+#endif
 }
 
 bool CCUtils::createFolder(string path) {
@@ -340,13 +443,14 @@ bool CCUtils::createFolder(string path) {
 	NSString* nsPath = [NSString stringWithFormat:@"%s", mappedPath.c_str()];
 	NSFileManager* fm = [NSFileManager defaultManager];
 	return [fm createDirectoryAtPath:nsPath withIntermediateDirectories:YES attributes:NULL error:NULL];
-#elif CC_TARGET_PLATFORM == CC_PLATFORM_ANDROID
-	return mkdir(path.c_str(), S_IRUSR | S_IWUSR | S_IXUSR | S_IRGRP | S_IXGRP | S_IROTH | S_IXOTH) == 0;
+#elif CC_TARGET_PLATFORM == CC_PLATFORM_ANDROID || CC_TARGET_PLATFORM == CC_PLATFORM_LINUX
+	string mappedPath = mapLocalPath(path);
+	return mkdir(mappedPath.c_str(), S_IRUSR | S_IWUSR | S_IXUSR | S_IRGRP | S_IXGRP | S_IROTH | S_IXOTH) == 0;
 #elif CC_TARGET_PLATFORM == CC_PLATFORM_WIN32
 	string mappedPath = mapLocalPath(path);
 	return CreateDirectory(mappedPath.c_str(), NULL) != 0;
 #else
-	CCLOGERROR("CCUtils::mapLocalPath is not implemented for this platform, please finish it");
+	CCLOGERROR("CCUtils::createFolder is not implemented for this platform, please finish it");
 	return false;
 #endif
 }
@@ -362,17 +466,97 @@ bool CCUtils::isPathExistent(string path) {
 #if CC_TARGET_PLATFORM == CC_PLATFORM_IOS || CC_TARGET_PLATFORM == CC_PLATFORM_MAC
 	NSString* nsPath = [NSString stringWithFormat:@"%s", mappedPath.c_str()];
 	return [[NSFileManager defaultManager] fileExistsAtPath:nsPath];
-#elif CC_TARGET_PLATFORM == CC_PLATFORM_ANDROID
+#elif CC_TARGET_PLATFORM == CC_PLATFORM_ANDROID || CC_TARGET_PLATFORM == CC_PLATFORM_LINUX
 	return access(mappedPath.c_str(), 0) == 0;
 #elif CC_TARGET_PLATFORM == CC_PLATFORM_WIN32
 	DWORD dwAttrib = GetFileAttributes((LPCTSTR)mappedPath.c_str());
 	return dwAttrib != INVALID_FILE_ATTRIBUTES;
 #else
-	CCLOGERROR("CCUtils::mapLocalPath is not implemented for this platform, please finish it");
+	CCLOGERROR("CCUtils::isPathExistent is not implemented for this platform, please finish it");
 	return false;
 #endif
 }
 
+void CCUtils::statPaths(const StringList& paths, vector<FileStat>& out) {
+	out.resize(paths.size());
+	
+#if CC_TARGET_PLATFORM == CC_PLATFORM_ANDROID || CC_TARGET_PLATFORM == CC_PLATFORM_LINUX
+	// paths in same folder share a directory descriptor, so only name is resolved
+	int dirfd = -1;
+	string dir;
+	bool dirOpened = false;
+#endif
+	
+	for(size_t i = 0; i < paths.size(); i++) {
+		FileStat& fs = out[i];
+		fs.exists = false;
+		fs.directory = false;
+		fs.size = 0;
+		fs.modifyTime = 0;
+		
+		// empty path is same as isPathExistent
+		if(paths[i].empty()) {
+			fs.exists = true;
+			fs.directory = true;
+			continue;
+		}
+		string mappedPath = mapLocalPath(paths[i]);
+		
+#if CC_TARGET_PLATFORM == CC_PLATFORM_WIN32
+		WIN32_FILE_ATTRIBUTE_DATA data;
+		if(GetFileAttributesEx(mappedPath.c_str(), GetFileExInfoStandard, &data)) {
+			fs.exists = true;
+			fs.directory = (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0;
+			fs.size = ((int64_t)data.nFileSizeHigh << 32) | data.nFileSizeLow;
+			
+			// file time is 100ns from 1601-1-1
+			int64_t t = ((int64_t)data.ftLastWriteTime.dwHighDateTime << 32) | data.ftLastWriteTime.dwLowDateTime;
+			fs.modifyTime = t / 10000000LL - 11644473600LL;
+		}
+#else
+		struct stat st;
+		int ret;
+	#if CC_TARGET_PLATFORM == CC_PLATFORM_ANDROID || CC_TARGET_PLATFORM == CC_PLATFORM_LINUX
+		size_t slash = mappedPath.rfind('/');
+		string parent = slash == string::npos ? "." : (slash == 0 ? "/" : mappedPath.substr(0, slash));
+		if(!dirOpened || parent != dir) {
+			if(dirfd >= 0)
+				close(dirfd);
+			dirfd = open(parent.c_str(), O_RDONLY | O_DIRECTORY);
+			dir = parent;
+			dirOpened = true;
+		}
+		if(dirfd >= 0)
+			ret = fstatat(dirfd, mappedPath.c_str() + (slash == string::npos ? 0 : slash + 1), &st, 0);
+		else
+			ret = stat(mappedPath.c_str(), &st);
+	#else
+		ret = stat(mappedPath.c_str(), &st);
+	#endif
+		if(ret == 0) {
+			fs.exists = true;
+			fs.directory = S_ISDIR(st.st_mode);
+			fs.size = st.st_size;
+			fs.modifyTime = st.st_mtime;
+		}
+#endif
+	}
+	
+#if CC_TARGET_PLATFORM == CC_PLATFORM_ANDROID || CC_TARGET_PLATFORM == CC_PLATFORM_LINUX
+	if(dirfd >= 0)
+		close(dirfd);
+#endif
+}
+
+void CCUtils::arePathsExistent(const StringList& paths, vector<bool>& out) {
+	vector<FileStat> stats;
+	statPaths(paths, stats);
+	out.resize(stats.size());
+	for(size_t i = 0; i < stats.size(); i++) {
+		out[i] = stats[i].exists;
+	}
+}
+
 string CCUtils::getPackageName() {
 #if CC_TARGET_PLATFORM == CC_PLATFORM_IOS || CC_TARGET_PLATFORM == CC_PLATFORM_MAC
 	NSBundle* bundle = [NSBundle mainBundle];
@@ -400,9 +584,17 @@ string CCUtils::getPackageName() {
 	
 	// return
 	return pn;
+#elif CC_TARGET_PLATFORM == CC_PLATFORM_LINUX
+	// use executable name
+	char buf[1024];
+	ssize_t len = readlink("/proc/self/exe", buf, sizeof(buf) - 1);
+	if(len <= 0)
+		return "";
+	buf[len] = 0;
+	return lastPathComponent(buf);
 #else
 	CCLOGERROR("CCUtils::getPackageName is not implemented for this platform, please finish it");
-	return false;
+	return "";
 #endif
 }
 
@@ -422,21 +614,20 @@ ccColorHSV CCUtils::ccc32hsv(ccColor3B c) {
     // get s
     float s = (float)delta / max;
 	
-    // get h
+    // get h in sextant, wrap negative before scaling so batch kernels can
+    // repeat exactly same float operations
     float h;
     if(c.r == max) {
         h = (float)(c.g - c.b) / delta;
     } else if (c.g == max) {
-        h = 2 + (float)(c.b - c.r) / delta;
+        h = (float)(c.b - c.r) / delta + 2;
     } else { // b == max
-        h = 4 + (float)(c.r - c.g) / delta;
+        h = (float)(c.r - c.g) / delta + 4;
     }
-	
-    // adjust h
-    h *= 60;
     if (h < 0) {
-        h += 360;
+        h += 6;
     }
+    h *= 60;
 	
     return cchsv(h, s, v);
 }
@@ -453,7 +644,7 @@ ccColor3B CCUtils::hsv2ccc3(ccColorHSV c) {
     int hx = (c.h < 0 || c.h >= 360.f) ? 0 : (int)((c.h / 60) * (1 << 16));
     int f = hx & 0xFFFF;
 	
-    unsigned char v_scale = v + 1;
+    int v_scale = v + 1;
     unsigned char p = ((255 - s) * v_scale) >> 8;
     unsigned char q = ((255 - (s * f >> 16)) * v_scale) >> 8;
     unsigned char t = ((255 - (s * ((1 << 16) - f) >> 16)) * v_scale) >> 8;
@@ -495,6 +686,278 @@ ccColor3B CCUtils::hsv2ccc3(ccColorHSV c) {
     return ccc3(r, g, b);
 }
 
+/// adjust a hsv color, dh must be in [0, 360)
+static inline ccColorHSV adjustHSVColor(ccColorHSV c, float dh, float ds, float dv) {
+	c.h += dh;
+	if(c.h >= 360)
+		c.h -= 360;
+	c.s = clampf(c.s + ds, 0, 1);
+	c.v = clampf(c.v + dv, 0, 1);
+	return c;
+}
+
+/*
+Batch color conversion. Four colors are converted in parallel lanes, every lane
+performs exactly same float operations as the scalar version, divisions included,
+so result is bit-identical. Integer products of hsv to rgb are all below 2^24 so
+they are done in float without loss when there is no 32 bits integer multiply.
+NEON kernel requires vector division, so it is only enabled for arm64
+*/
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#include <emmintrin.h>
+	#define HSV_LANES 4
+	typedef __m128 VFLOAT4;
+	typedef __m128i VINT4;
+	typedef __m128i VMASK4;
+	#define VF_LOAD(p) _mm_loadu_ps(p)
+	#define VF_STORE(p, v) _mm_storeu_ps((p), (v))
+	#define VI_STORE(p, v) _mm_storeu_si128((__m128i*)(p), (v))
+	#define VF_SET1(x) _mm_set1_ps(x)
+	#define VI_SET1(x) _mm_set1_epi32(x)
+	#define VF_ADD(a, b) _mm_add_ps((a), (b))
+	#define VF_SUB(a, b) _mm_sub_ps((a), (b))
+	#define VF_MUL(a, b) _mm_mul_ps((a), (b))
+	#define VF_DIV(a, b) _mm_div_ps((a), (b))
+	#define VF_MIN(a, b) _mm_min_ps((a), (b))
+	#define VF_MAX(a, b) _mm_max_ps((a), (b))
+	#define VF_EQ(a, b) _mm_castps_si128(_mm_cmpeq_ps((a), (b)))
+	#define VF_LT(a, b) _mm_castps_si128(_mm_cmplt_ps((a), (b)))
+	#define VF_GE(a, b) _mm_castps_si128(_mm_cmpge_ps((a), (b)))
+	#define VF_SELECT(m, a, b) _mm_or_ps(_mm_and_ps(_mm_castsi128_ps(m), (a)), _mm_andnot_ps(_mm_castsi128_ps(m), (b)))
+	#define VF_TO_INT(v) _mm_cvttps_epi32(v)
+	#define VI_TO_FLOAT(v) _mm_cvtepi32_ps(v)
+	#define VI_ADD(a, b) _mm_add_epi32((a), (b))
+	#define VI_SUB(a, b) _mm_sub_epi32((a), (b))
+	#define VI_MUL(a, b) _mm_cvttps_epi32(_mm_mul_ps(_mm_cvtepi32_ps(a), _mm_cvtepi32_ps(b)))
+	#define VI_AND(a, b) _mm_and_si128((a), (b))
+	#define VI_SRA(v, n) _mm_srai_epi32((v), (n))
+	#define VI_EQ(a, b) _mm_cmpeq_epi32((a), (b))
+	#define VI_SELECT(m, a, b) _mm_or_si128(_mm_and_si128((m), (a)), _mm_andnot_si128((m), (b)))
+	#define VM_AND(a, b) _mm_and_si128((a), (b))
+	#define VM_OR(a, b) _mm_or_si128((a), (b))
+#elif (defined(__ARM_NEON__) || defined(__ARM_NEON)) && defined(__aarch64__)
+	#include <arm_neon.h>
+	#define HSV_LANES 4
+	typedef float32x4_t VFLOAT4;
+	typedef int32x4_t VINT4;
+	typedef uint32x4_t VMASK4;
+	#define VF_LOAD(p) vld1q_f32(p)
+	#define VF_STORE(p, v) vst1q_f32((p), (v))
+	#define VI_STORE(p, v) vst1q_s32((p), (v))
+	#define VF_SET1(x) vdupq_n_f32(x)
+	#define VI_SET1(x) vdupq_n_s32(x)
+	#define VF_ADD(a, b) vaddq_f32((a), (b))
+	#define VF_SUB(a, b) vsubq_f32((a), (b))
+	#define VF_MUL(a, b) vmulq_f32((a), (b))
+	#define VF_DIV(a, b) vdivq_f32((a), (b))
+	#define VF_MIN(a, b) vminq_f32((a), (b))
+	#define VF_MAX(a, b) vmaxq_f32((a), (b))
+	#define VF_EQ(a, b) vceqq_f32((a), (b))
+	#define VF_LT(a, b) vcltq_f32((a), (b))
+	#define VF_GE(a, b) vcgeq_f32((a), (b))
+	#define VF_SELECT(m, a, b) vbslq_f32((m), (a), (b))
+	#define VF_TO_INT(v) vcvtq_s32_f32(v)
+	#define VI_TO_FLOAT(v) vcvtq_f32_s32(v)
+	#define VI_ADD(a, b) vaddq_s32((a), (b))
+	#define VI_SUB(a, b) vsubq_s32((a), (b))
+	#define VI_MUL(a, b) vmulq_s32((a), (b))
+	#define VI_AND(a, b) vandq_s32((a), (b))
+	#define VI_SRA(v, n) vshrq_n_s32((v), (n))
+	#define VI_EQ(a, b) vceqq_s32((a), (b))
+	#define VI_SELECT(m, a, b) vbslq_s32((m), (a), (b))
+	#define VM_AND(a, b) vandq_u32((a), (b))
+	#define VM_OR(a, b) vorrq_u32((a), (b))
+#endif
+
+#ifdef HSV_LANES
+
+/// rgb to hsv of four colors, channels are integer values in float
+static void rgbToHSV4(const float* r, const float* g, const float* b, float* h, float* s, float* v) {
+	VFLOAT4 vr = VF_LOAD(r), vg = VF_LOAD(g), vb = VF_LOAD(b);
+	VFLOAT4 zero = VF_SET1(0);
+	VFLOAT4 max = VF_MAX(vr, VF_MAX(vg, vb));
+	VFLOAT4 min = VF_MIN(vr, VF_MIN(vg, vb));
+	VFLOAT4 delta = VF_SUB(max, min);
+	VMASK4 gray = VF_EQ(delta, zero);
+	
+	// v and s, gray lanes may divide by zero but they are masked
+	VFLOAT4 vv = VF_DIV(max, VF_SET1(255.f));
+	VFLOAT4 vs = VF_SELECT(gray, zero, VF_DIV(delta, max));
+	
+	// h, r is checked before g, same as scalar version
+	VMASK4 rMax = VF_EQ(vr, max);
+	VMASK4 gMax = VF_EQ(vg, max);
+	VFLOAT4 num = VF_SELECT(rMax, VF_SUB(vg, vb), VF_SELECT(gMax, VF_SUB(vb, vr), VF_SUB(vr, vg)));
+	VFLOAT4 base = VF_SELECT(rMax, zero, VF_SELECT(gMax, VF_SET1(2), VF_SET1(4)));
+	VFLOAT4 hh = VF_DIV(num, delta);
+	hh = VF_SELECT(rMax, hh, VF_ADD(hh, base));
+	hh = VF_SELECT(VF_LT(hh, zero), VF_ADD(hh, VF_SET1(6)), hh);
+	hh = VF_MUL(hh, VF_SET1(60));
+	hh = VF_SELECT(gray, zero, hh);
+	
+	VF_STORE(h, hh);
+	VF_STORE(s, vs);
+	VF_STORE(v, vv);
+}
+
+/// same as UnitScalarToByte
+static inline VINT4 unitScalarToByte4(VFLOAT4 x) {
+	VINT4 b = VI_SRA(VF_TO_INT(VF_MUL(x, VF_SET1(65536.f))), 8);
+	b = VI_SELECT(VF_GE(x, VF_SET1(1)), VI_SET1(255), b);
+	return VI_SELECT(VF_LT(x, VF_SET1(0)), VI_SET1(0), b);
+}
+
+/// hsv to rgb of four colors
+static void hsvToRGB4(const float* h, const float* s, const float* v, int* r, int* g, int* b) {
+	VFLOAT4 vh = VF_LOAD(h);
+	VINT4 s8 = unitScalarToByte4(VF_LOAD(s));
+	VINT4 v8 = unitScalarToByte4(VF_LOAD(v));
+	
+	// sector and fraction
+	VMASK4 valid = VM_AND(VF_GE(vh, VF_SET1(0)), VF_LT(vh, VF_SET1(360.f)));
+	VINT4 hx = VF_TO_INT(VF_MUL(VF_DIV(vh, VF_SET1(60)), VF_SET1(65536.f)));
+	hx = VI_SELECT(valid, hx, VI_SET1(0));
+	VINT4 f = VI_AND(hx, VI_SET1(0xFFFF));
+	VINT4 sector = VI_SRA(hx, 16);
+	
+	// p, q, t
+	VINT4 c255 = VI_SET1(255);
+	VINT4 vScale = VI_ADD(v8, VI_SET1(1));
+	VINT4 p = VI_SRA(VI_MUL(VI_SUB(c255, s8), vScale), 8);
+	VINT4 q = VI_SRA(VI_MUL(VI_SUB(c255, VI_SRA(VI_MUL(s8, f), 16)), vScale), 8);
+	VINT4 t = VI_SRA(VI_MUL(VI_SUB(c255, VI_SRA(VI_MUL(s8, VI_SUB(VI_SET1(1 << 16), f)), 16)), vScale), 8);
+	
+	// pick by sector, anything else is same as sector 5
+	VMASK4 s0 = VI_EQ(sector, VI_SET1(0));
+	VMASK4 s1 = VI_EQ(sector, VI_SET1(1));
+	VMASK4 s2 = VI_EQ(sector, VI_SET1(2));
+	VMASK4 s3 = VI_EQ(sector, VI_SET1(3));
+	VMASK4 s4 = VI_EQ(sector, VI_SET1(4));
+	VINT4 vr = VI_SELECT(s1, q, VI_SELECT(VM_OR(s2, s3), p, VI_SELECT(s4, t, v8)));
+	VINT4 vg = VI_SELECT(s0, t, VI_SELECT(VM_OR(s1, s2), v8, VI_SELECT(s3, q, p)));
+	VINT4 vb = VI_SELECT(VM_OR(s0, s1), p, VI_SELECT(s2, t, VI_SELECT(VM_OR(s3, s4), v8, q)));
+	
+	// gray
+	VMASK4 gray = VI_EQ(s8, VI_SET1(0));
+	VI_STORE(r, VI_SELECT(gray, v8, vr));
+	VI_STORE(g, VI_SELECT(gray, v8, vg));
+	VI_STORE(b, VI_SELECT(gray, v8, vb));
+}
+
+/// same as adjustHSVColor for four colors
+static void adjustHSV4(float* h, float* s, float* v, float dh, float ds, float dv) {
+	VFLOAT4 c360 = VF_SET1(360);
+	VFLOAT4 zero = VF_SET1(0);
+	VFLOAT4 one = VF_SET1(1);
+	VFLOAT4 vh = VF_ADD(VF_LOAD(h), VF_SET1(dh));
+	vh = VF_SELECT(VF_GE(vh, c360), VF_SUB(vh, c360), vh);
+	VF_STORE(h, vh);
+	VF_STORE(s, VF_MIN(VF_MAX(VF_ADD(VF_LOAD(s), VF_SET1(ds)), zero), one));
+	VF_STORE(v, VF_MIN(VF_MAX(VF_ADD(VF_LOAD(v), VF_SET1(dv)), zero), one));
+}
+
+#endif // #ifdef HSV_LANES
+
+void CCUtils::ccc32hsv(const ccColor3B* src, ccColorHSV* dst, size_t count) {
+	size_t i = 0;
+#ifdef HSV_LANES
+	float r[4], g[4], b[4], h[4], s[4], v[4];
+	for(; i + 4 <= count; i += 4) {
+		for(int j = 0; j < 4; j++) {
+			r[j] = src[i + j].r;
+			g[j] = src[i + j].g;
+			b[j] = src[i + j].b;
+		}
+		rgbToHSV4(r, g, b, h, s, v);
+		for(int j = 0; j < 4; j++) {
+			dst[i + j] = cchsv(h[j], s[j], v[j]);
+		}
+	}
+#endif
+	for(; i < count; i++) {
+		dst[i] = ccc32hsv(src[i]);
+	}
+}
+
+void CCUtils::hsv2ccc3(const ccColorHSV* src, ccColor3B* dst, size_t count) {
+	size_t i = 0;
+#ifdef HSV_LANES
+	float h[4], s[4], v[4];
+	int r[4], g[4], b[4];
+	for(; i + 4 <= count; i += 4) {
+		for(int j = 0; j < 4; j++) {
+			h[j] = src[i + j].h;
+			s[j] = src[i + j].s;
+			v[j] = src[i + j].v;
+		}
+		hsvToRGB4(h, s, v, r, g, b);
+		for(int j = 0; j < 4; j++) {
+			dst[i + j] = ccc3(r[j], g[j], b[j]);
+		}
+	}
+#endif
+	for(; i < count; i++) {
+		dst[i] = hsv2ccc3(src[i]);
+	}
+}
+
+/// normalize hue offset to [0, 360)
+static float normalizeHueOffset(float dh) {
+	dh = fmodf(dh, 360);
+	if(dh < 0)
+		dh += 360;
+	if(dh >= 360)
+		dh = 0;
+	return dh;
+}
+
+/// adjust hsv of pixels, stride is bytes between two pixels
+static void adjustHSVPixels(unsigned char* pixels, size_t count, size_t stride, float dh, float ds, float dv) {
+	dh = normalizeHueOffset(dh);
+	size_t i = 0;
+#ifdef HSV_LANES
+	float r[4], g[4], b[4], h[4], s[4], v[4];
+	int ri[4], gi[4], bi[4];
+	for(; i + 4 <= count; i += 4) {
+		unsigned char* p = pixels + i * stride;
+		for(int j = 0; j < 4; j++, p += stride) {
+			r[j] = p[0];
+			g[j] = p[1];
+			b[j] = p[2];
+		}
+		rgbToHSV4(r, g, b, h, s, v);
+		adjustHSV4(h, s, v, dh, ds, dv);
+		hsvToRGB4(h, s, v, ri, gi, bi);
+		p = pixels + i * stride;
+		for(int j = 0; j < 4; j++, p += stride) {
+			p[0] = ri[j];
+			p[1] = gi[j];
+			p[2] = bi[j];
+		}
+	}
+#endif
+	for(; i < count; i++) {
+		unsigned char* p = pixels + i * stride;
+		ccColorHSV c = CCUtils::ccc32hsv(ccc3(p[0], p[1], p[2]));
+		ccColor3B rgb = CCUtils::hsv2ccc3(adjustHSVColor(c, dh, ds, dv));
+		p[0] = rgb.r;
+		p[1] = rgb.g;
+		p[2] = rgb.b;
+	}
+}
+
+void CCUtils::adjustHSV(ccColor3B* colors, size_t count, float dh, float ds, float dv) {
+	adjustHSVPixels((unsigned char*)colors, count, sizeof(ccColor3B), dh, ds, dv);
+}
+
+void CCUtils::adjustHSV(ccColor4B* colors, size_t count, float dh, float ds, float dv) {
+	adjustHSVPixels((unsigned char*)colors, count, sizeof(ccColor4B), dh, ds, dv);
+}
+
+void CCUtils::adjustHSVRGBA8(unsigned char* pixels, size_t count, float dh, float ds, float dv) {
+	adjustHSVPixels(pixels, count, 4, dh, ds, dv);
+}
+
 CCPoint CCUtils::getOrigin(CCNode* node) {
 	if(node->isIgnoreAnchorPointForPosition()) {
 		return node->getPosition();
@@ -625,8 +1088,12 @@ bool CCUtils::hasExternalStorage() {
     // is same?
     JniHelper::getMethodInfo(t, "java/lang/Object", "equals", "(Ljava/lang/Object;)Z");
     return t.env->CallBooleanMethod(jMounted, t.methodID, jState);
+#elif CC_TARGET_PLATFORM == CC_PLATFORM_LINUX
+    // desktop file system is always there
+    return true;
 #else
     CCLOGERROR("CCUtils::hasExternalStorage is not implemented for this platform, please finish it");
+    return false;
 #endif
 }
 
@@ -676,7 +1143,8 @@ bool CCUtils::verifySignature(void* validSign, size_t len) {
 	jsize cLen = t.env->GetArrayLength(certificate);
 	jbyte* cData = t.env->GetByteArrayElements(certificate, JNI_FALSE);
 	if (cLen > 0) {
-		const char* md5 = CCMD5::md5(cData, cLen);
+		char md5[33];
+		CCMD5::md5(cData, cLen, md5);
 		size_t md5Len = strlen(md5);
 		if(md5Len != len) {
 			valid = false;
@@ -701,41 +1169,304 @@ bool CCUtils::verifySignature(void* validSign, size_t len) {
 #endif
 }
 
-CCUtils::StringList& CCUtils::componentsOfString(const string& s, const char sep) {
+void CCUtils::ComponentIterator::init(const char* s, size_t len, char sep) {
     // remove head and tailing brace, bracket, parentheses
-    int start = 0;
-    int end = s.length() - 1;
-    char c = s[start];
-    while(c == '{' || c == '[' || c == '(') {
+    const char* start = s;
+    const char* end = s + len;
+    while(start < end && (*start == '{' || *start == '[' || *start == '(')) {
         start++;
-        c = s[start];
     }
-    c = s[end];
-    while(c == '}' || c == ']' || c == ')') {
+    while(end > start && (end[-1] == '}' || end[-1] == ']' || end[-1] == ')')) {
         end--;
-        c = s[end];
     }
     
-    // returned string list
-    s_tmpStringList.clear();
+    m_cur = start;
+    m_end = end;
+    m_sep = sep;
+    m_done = start >= end;
+}
+
+bool CCUtils::ComponentIterator::next(const char** comp, size_t* len) {
+    if(m_done)
+        return false;
     
-    // iterate string
-    int compStart = start;
-    for(int i = start; i <= end; i++) {
-        c = s[i];
-        if(c == sep) {
-            s_tmpStringList.push_back(s.substr(compStart, i - compStart));
-            compStart = i + 1;
-        } else if(c == ' ' || c == '\t' || c == '\r' || c == '\n') {
-            if(compStart == i) {
-                compStart++;
+    // skip leading white space
+    const char* p = m_cur;
+    while(p < m_end && *p != m_sep && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n')) {
+        p++;
+    }
+    
+    // nothing left after last separator
+    if(p >= m_end) {
+        m_done = true;
+        return false;
+    }
+    
+    // find separator
+    const char* q = p;
+    while(q < m_end && *q != m_sep) {
+        q++;
+    }
+    *comp = p;
+    *len = q - p;
+    if(q < m_end)
+        m_cur = q + 1;
+    else
+        m_done = true;
+    return true;
+}
+
+/// powers of ten which are exact in double
+static const double s_exactPowersOf10[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10,
+    1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20,
+    1e21, 1e22
+};
+
+/// parse a number with strtod, '.' is replaced with decimal point of C locale first
+static double strtodWithDot(const char* s, size_t len) {
+#if CC_TARGET_PLATFORM == CC_PLATFORM_ANDROID
+    // bionic only has C locale
+    const char* dp = ".";
+#else
+    const char* dp = localeconv()->decimal_point;
+    if(!dp || !dp[0])
+        dp = ".";
+#endif
+    size_t dpLen = strlen(dp);
+    
+    // copy to a null terminated buffer, stack buffer is enough for most numbers
+    char stackBuf[64];
+    string heapBuf;
+    char* buf = stackBuf;
+    if(len + dpLen >= sizeof(stackBuf)) {
+        heapBuf.resize(len + dpLen);
+        buf = &heapBuf[0];
+    }
+    char* q = buf;
+    for(size_t i = 0; i < len; i++) {
+        if(s[i] == '.') {
+            memcpy(q, dp, dpLen);
+            q += dpLen;
+        } else {
+            *q++ = s[i];
+        }
+    }
+    *q = 0;
+    return strtod(buf, NULL);
+}
+
+#define IS_OPEN_BRACE(c) ((c) == '{' || (c) == '[' || (c) == '(')
+#define IS_CLOSE_BRACE(c) ((c) == '}' || (c) == ']' || (c) == ')')
+#define IS_WHITE_SPACE(c) ((c) == ' ' || (c) == '\t' || (c) == '\r' || (c) == '\n')
+
+double CCUtils::parseDouble(const char* s, size_t len, size_t* used) {
+    const char* p = s;
+    const char* end = s + len;
+    
+    // white space and sign
+    while(p < end && IS_WHITE_SPACE(*p))
+        p++;
+    const char* start = p;
+    bool negative = false;
+    if(p < end && (*p == '+' || *p == '-')) {
+        negative = *p == '-';
+        p++;
+    }
+    
+    // mantissa, keep at most 19 significant digits
+    uint64_t m = 0;
+    int digits = 0;
+    int exp10 = 0;
+    bool hasDigit = false;
+    bool truncated = false;
+    while(p < end && *p >= '0' && *p <= '9') {
+        hasDigit = true;
+        if(digits < 19) {
+            m = m * 10 + (*p - '0');
+            if(m > 0)
+                digits++;
+        } else {
+            exp10++;
+            truncated |= *p != '0';
+        }
+        p++;
+    }
+    if(p < end && *p == '.') {
+        p++;
+        while(p < end && *p >= '0' && *p <= '9') {
+            hasDigit = true;
+            if(digits < 19) {
+                m = m * 10 + (*p - '0');
+                exp10--;
+                if(m > 0)
+                    digits++;
+            } else {
+                truncated |= *p != '0';
             }
+            p++;
         }
     }
+    if(!hasDigit) {
+        if(used)
+            *used = 0;
+        return 0;
+    }
     
-    // last comp
-    if(compStart <= end) {
-        s_tmpStringList.push_back(s.substr(compStart, end - compStart + 1));
+    // exponent, only consumed when it has digits
+    if(p < end && (*p == 'e' || *p == 'E')) {
+        const char* q = p + 1;
+        bool expNegative = false;
+        if(q < end && (*q == '+' || *q == '-')) {
+            expNegative = *q == '-';
+            q++;
+        }
+        if(q < end && *q >= '0' && *q <= '9') {
+            int e = 0;
+            while(q < end && *q >= '0' && *q <= '9') {
+                if(e < 100000)
+                    e = e * 10 + (*q - '0');
+                q++;
+            }
+            exp10 += expNegative ? -e : e;
+            p = q;
+        }
+    }
+    if(used)
+        *used = p - s;
+    
+    // compute
+    double v;
+    if(m == 0) {
+        v = 0;
+    } else if(!truncated && m <= (1ULL << 53) && exp10 >= -22 && exp10 <= 22) {
+        // both mantissa and power are exact, so one operation gives correctly rounded result
+        v = (double)m;
+        if(exp10 < 0)
+            v /= s_exactPowersOf10[-exp10];
+        else
+            v *= s_exactPowersOf10[exp10];
+    } else if(exp10 < -350) {
+        // less than half of smallest denormal even with 19 digits
+        v = 0;
+    } else if(exp10 > 350) {
+        v = HUGE_VAL;
+    } else {
+        // rare case, scaling can't be exact so let C library round it, it has sign
+        return strtodWithDot(start, p - start);
+    }
+    return negative ? -v : v;
+}
+
+/// parse at most count floats from a string, missing ones are zero
+static void parseFloats(const string& s, float* out, int count) {
+    CCUtils::ComponentIterator iter(s, ',');
+    const char* comp;
+    size_t len;
+    int i = 0;
+    for(; i < count && iter.next(&comp, &len); i++) {
+        out[i] = CCUtils::parseDouble(comp, len);
+    }
+    for(; i < count; i++) {
+        out[i] = 0;
+    }
+}
+
+/**
+ * parse next literal in a buffer, at most count floats is saved and missing ones are zero.
+ * Returns position after the literal, or NULL if no more literal
+ */
+static const char* parseNextLiteral(const char* p, const char* end, float* out, int count) {
+    // find opening brace
+    while(p < end && !IS_OPEN_BRACE(*p))
+        p++;
+    if(p >= end)
+        return NULL;
+    while(p < end && IS_OPEN_BRACE(*p))
+        p++;
+    
+    // components
+    int i = 0;
+    while(p < end) {
+        while(p < end && *p != ',' && IS_WHITE_SPACE(*p))
+            p++;
+        if(p >= end || IS_CLOSE_BRACE(*p) || IS_OPEN_BRACE(*p))
+            break;
+        
+        size_t used;
+        double v = CCUtils::parseDouble(p, end - p, &used);
+        if(i < count)
+            out[i] = v;
+        i++;
+        p += used;
+        
+        // skip rest of component
+        while(p < end && *p != ',' && !IS_CLOSE_BRACE(*p) && !IS_OPEN_BRACE(*p))
+            p++;
+        if(p < end && *p == ',')
+            p++;
+    }
+    for(; i < count; i++) {
+        out[i] = 0;
+    }
+    
+    // closing brace
+    while(p < end && IS_CLOSE_BRACE(*p))
+        p++;
+    return p;
+}
+
+size_t CCUtils::ccpArrayFromString(const char* s, size_t len, CCPoint* out, size_t max) {
+    const char* p = s;
+    const char* end = s + len;
+    size_t n = 0;
+    float f[2];
+    while(n < max && (p = parseNextLiteral(p, end, f, 2)) != NULL) {
+        out[n].x = f[0];
+        out[n].y = f[1];
+        n++;
+    }
+    return n;
+}
+
+size_t CCUtils::ccsArrayFromString(const char* s, size_t len, CCSize* out, size_t max) {
+    const char* p = s;
+    const char* end = s + len;
+    size_t n = 0;
+    float f[2];
+    while(n < max && (p = parseNextLiteral(p, end, f, 2)) != NULL) {
+        out[n].width = f[0];
+        out[n].height = f[1];
+        n++;
+    }
+    return n;
+}
+
+size_t CCUtils::ccrArrayFromString(const char* s, size_t len, CCRect* out, size_t max) {
+    const char* p = s;
+    const char* end = s + len;
+    size_t n = 0;
+    float f[4];
+    while(n < max && (p = parseNextLiteral(p, end, f, 4)) != NULL) {
+        out[n].origin.x = f[0];
+        out[n].origin.y = f[1];
+        out[n].size.width = f[2];
+        out[n].size.height = f[3];
+        n++;
+    }
+    return n;
+}
+
+CCUtils::StringList& CCUtils::componentsOfString(const string& s, const char sep) {
+    // returned string list
+    s_tmpStringList.clear();
+    
+    // iterate string
+    ComponentIterator iter(s, sep);
+    const char* comp;
+    size_t len;
+    while(iter.next(&comp, &len)) {
+        s_tmpStringList.push_back(string(comp, len));
     }
     
     // return
@@ -743,70 +1474,233 @@ CCUtils::StringList& CCUtils::componentsOfString(const string& s, const char sep
 }
 
 CCPoint CCUtils::ccpFromString(const string& s) {
-    StringList comp = componentsOfString(s, ',');
-    float x = 0, y = 0;
-    if(comp.size() > 0) {
-        x = atof(comp.at(0).c_str());
-    }
-    if(comp.size() > 1) {
-        y = atof(comp.at(1).c_str());
-    }
-    return ccp(x, y);
+    float f[2];
+    parseFloats(s, f, 2);
+    return ccp(f[0], f[1]);
 }
 
 CCSize CCUtils::ccsFromString(const string& s) {
-    StringList comp = componentsOfString(s, ',');
-    float x = 0, y = 0;
-    if(comp.size() > 0) {
-        x = atof(comp.at(0).c_str());
+    float f[2];
+    parseFloats(s, f, 2);
+    return CCSizeMake(f[0], f[1]);
+}
+
+CCRect CCUtils::ccrFromString(const string& s) {
+    float f[4];
+    parseFloats(s, f, 4);
+    return CCRectMake(f[0], f[1], f[2], f[3]);
+}
+
+void CCUtils::ValueArray::addFloat(float f) {
+    Value v;
+    v.type = FLOAT;
+    v.v.f = f;
+    v.length = 0;
+    m_values.push_back(v);
+}
+
+void CCUtils::ValueArray::addDouble(double d) {
+    Value v;
+    v.type = DOUBLE;
+    v.v.d = d;
+    v.length = 0;
+    m_values.push_back(v);
+}
+
+void CCUtils::ValueArray::addInteger(int i) {
+    Value v;
+    v.type = INTEGER;
+    v.v.i = i;
+    v.length = 0;
+    m_values.push_back(v);
+}
+
+void CCUtils::ValueArray::addString(const char* s, size_t len) {
+    Value v;
+    v.type = STRING;
+    v.v.offset = m_pool.length();
+    v.length = len;
+    m_values.push_back(v);
+    m_pool.append(s, len);
+    m_pool.push_back('\0');
+}
+
+float CCUtils::ValueArray::getFloat(size_t index) const {
+    return (float)getDouble(index);
+}
+
+double CCUtils::ValueArray::getDouble(size_t index) const {
+    const Value& v = m_values[index];
+    switch(v.type) {
+        case FLOAT:
+            return v.v.f;
+        case DOUBLE:
+            return v.v.d;
+        case INTEGER:
+            return v.v.i;
+        default:
+            return CCUtils::parseDouble(m_pool.data() + v.v.offset, v.length);
     }
-    if(comp.size() > 1) {
-        y = atof(comp.at(1).c_str());
+}
+
+int CCUtils::ValueArray::getInteger(size_t index) const {
+    const Value& v = m_values[index];
+    switch(v.type) {
+        case FLOAT:
+            return (int)v.v.f;
+        case DOUBLE:
+            return (int)v.v.d;
+        case INTEGER:
+            return v.v.i;
+        default:
+            return (int)CCUtils::parseDouble(m_pool.data() + v.v.offset, v.length);
     }
-    return CCSizeMake(x, y);
 }
 
-CCRect CCUtils::ccrFromString(const string& s) {
-    StringList comp = componentsOfString(s, ',');
-    float x = 0, y = 0, w = 0, h = 0;
-    if(comp.size() > 0) {
-        x = atof(comp.at(0).c_str());
+const char* CCUtils::ValueArray::getString(size_t index) const {
+    const Value& v = m_values[index];
+    if(v.type == STRING)
+        return m_pool.c_str() + v.v.offset;
+    else
+        return "";
+}
+
+size_t CCUtils::ValueArray::getStringLength(size_t index) const {
+    const Value& v = m_values[index];
+    return v.type == STRING ? v.length : 0;
+}
+
+/// replace decimal point of C locale with '.' in a formatted number, returns new length
+static int fixDecimalPoint(char* buf, int len) {
+#if CC_TARGET_PLATFORM == CC_PLATFORM_ANDROID
+    // bionic only has C locale
+    return len;
+#else
+    const char* dp = localeconv()->decimal_point;
+    if(!dp || !dp[0] || (dp[0] == '.' && !dp[1]))
+        return len;
+    char* p = strstr(buf, dp);
+    if(!p)
+        return len;
+    int dpLen = (int)strlen(dp);
+    *p = '.';
+    memmove(p + 1, p + dpLen, len - (p - buf) - dpLen + 1);
+    return len - dpLen + 1;
+#endif
+}
+
+/*
+ * Shortest %g form which reads back to same value. Any decimal of FLT_DIG or DBL_DIG
+ * digits survives a round trip of a normal number, so if a shorter form exists, that
+ * many digits print it with trailing zeros removed. Search starts there and only adds
+ * digits when needed. Denormal has less precision so its search starts from 1 digit
+ */
+int CCUtils::formatFloat(float f, char* buf) {
+    int len = 0;
+    int precision = fabsf(f) < FLT_MIN ? 1 : FLT_DIG;
+    for(; precision <= 9; precision++) {
+        len = fixDecimalPoint(buf, sprintf(buf, "%.*g", precision, f));
+        if((float)parseDouble(buf, len) == f)
+            break;
     }
-    if(comp.size() > 1) {
-        y = atof(comp.at(1).c_str());
+    return len;
+}
+
+int CCUtils::formatDouble(double d, char* buf) {
+    int len = 0;
+    int precision = fabs(d) < DBL_MIN ? 1 : DBL_DIG;
+    for(; precision <= 17; precision++) {
+        len = fixDecimalPoint(buf, sprintf(buf, "%.*g", precision, d));
+        if(parseDouble(buf, len) == d)
+            break;
     }
-    if(comp.size() > 2) {
-        w = atof(comp.at(2).c_str());
+    return len;
+}
+
+CCUtils::ValueArray& CCUtils::arrayFromString(const string& s, ValueArray& out) {
+    return arrayFromString(s.c_str(), s.length(), out);
+}
+
+CCUtils::ValueArray& CCUtils::arrayFromString(const char* s, size_t len, ValueArray& out) {
+    out.clear();
+    ComponentIterator iter(s, len, ',');
+    const char* cs;
+    size_t clen;
+    while(iter.next(&cs, &clen)) {
+        if(clen > 0) {
+            if(cs[0] == '\'' || cs[0] == '"') {
+                int start = 1;
+                int end = clen - 1;
+                if(cs[end] == '\'' || cs[end] == '"') {
+                    end--;
+                }
+                if(end >= start) {
+                    out.addString(cs + start, end - start + 1);
+                } else {
+                    out.addString("", 0);
+                }
+            } else {
+                out.addFloat(parseDouble(cs, clen));
+            }
+        } else {
+            out.addFloat(0);
+        }
     }
-    if(comp.size() > 3) {
-        h = atof(comp.at(3).c_str());
+    return out;
+}
+
+string& CCUtils::arrayToString(const ValueArray& values, string& out) {
+    out.clear();
+    out.push_back('[');
+    char buf[32];
+    size_t count = values.size();
+    for(size_t i = 0; i < count; i++) {
+        if(i > 0)
+            out.push_back(',');
+        switch(values.getType(i)) {
+            case ValueArray::STRING:
+                out.push_back('"');
+                out.append(values.getString(i), values.getStringLength(i));
+                out.push_back('"');
+                break;
+            case ValueArray::INTEGER:
+                out.append(buf, sprintf(buf, "%d", values.getInteger(i)));
+                break;
+            case ValueArray::DOUBLE:
+                out.append(buf, formatDouble(values.getDouble(i), buf));
+                break;
+            default:
+                out.append(buf, formatFloat(values.getFloat(i), buf));
+                break;
+        }
     }
-    return CCRectMake(x, y, w, h);
+    out.push_back(']');
+    return out;
 }
 
 CCArray& CCUtils::arrayFromString(const string& s) {
-    StringList comp = componentsOfString(s, ',');
-    
     // clear
     s_tmpArray.removeAllObjects();
     
     // iterator components
-    for(StringList::iterator iter = comp.begin(); iter != comp.end(); iter++) {
-        string& cs = *iter;
-        if(cs.length() > 0) {
+    ComponentIterator iter(s, ',');
+    const char* cs;
+    size_t len;
+    while(iter.next(&cs, &len)) {
+        if(len > 0) {
             if(cs[0] == '\'' || cs[0] == '"') {
                 int start = 1;
-                int end = cs.length() - 1;
+                int end = len - 1;
                 if(cs[end] == '\'' || cs[end] == '"') {
                     end--;
                 }
                 if(end >= start) {
-                    s_tmpArray.addObject(CCString::create(cs.substr(start, end - start + 1)));
+                    s_tmpArray.addObject(CCString::create(string(cs + start, end - start + 1)));
                 } else {
                     s_tmpArray.addObject(CCString::create(""));
                 }
-            } else {                
-                float f = atof(cs.c_str());
+            } else {
+                float f = parseDouble(cs, len);
                 s_tmpArray.addObject(CCFloat::create(f));
             }
         } else {
@@ -943,6 +1837,8 @@ int CCUtils::getCpuHz() {
     JniMethodInfo t;
     JniHelper::getStaticMethodInfo(t, "org/cocos2dx/lib/SystemUtils", "getCPUFrequencyMax", "()I");
 	return t.env->CallStaticIntMethod(t.classID, t.methodID);
+#elif CC_TARGET_PLATFORM == CC_PLATFORM_LINUX
+    return (int)CCCpuInfo::getMaxFrequency();
 #else
     return 0;
 #endif
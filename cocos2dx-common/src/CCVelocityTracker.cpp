@@ -24,6 +24,7 @@
 #include "CCVelocityTracker.h"
 #include "VelocityTracker.h"
 #include "CCUtils.h"
+#include "CCClock.h"
 #include "CCMoreMacros.h"
 
 using namespace android;
@@ -37,8 +38,7 @@ static PointerCoords s_pc;
 
 static MotionEvent* convertCCTouchToMotionEvent(CCTouch* pcc, int eventMask) {
 	CCPoint loc = pcc->getLocation();
-	nsecs_t time = (nsecs_t)CCUtils::currentTimeMillis();
-	time = milliseconds_to_nanoseconds(time);
+	nsecs_t time = (nsecs_t)CCClock::nanoTime();
 	s_pp.id = pcc->getID();
 	MotionEvent* me = new MotionEvent();
 	me->initialize(0,
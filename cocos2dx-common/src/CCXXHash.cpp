@@ -0,0 +1,220 @@
+/****************************************************************************
+ Author: Luma (stubma@gmail.com)
+ 
+ https://github.com/stubma/cocos2dx-common
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ ****************************************************************************/
+#include "CCXXHash.h"
+#include <string.h>
+
+/* primes of xxhash64 */
+#define PRIME64_1 0x9E3779B185EBCA87ULL
+#define PRIME64_2 0xC2B2AE3D27D4EB4FULL
+#define PRIME64_3 0x165667B19E3779F9ULL
+#define PRIME64_4 0x85EBCA77C2B2AE63ULL
+#define PRIME64_5 0x27D4EB2F165667C5ULL
+
+#define ROTL64(x, r) (((x) << (r)) | ((x) >> (64 - (r))))
+
+/* little endian cpu can load words directly */
+#if (defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__) || defined(_M_IX86) || defined(_M_X64) || defined(_M_ARM)
+	#define XXH_LITTLE_ENDIAN 1
+#endif
+
+static const char HEX_DIGITS[] = "0123456789abcdef";
+
+static inline uint64_t readLE64(const unsigned char* p) {
+#ifdef XXH_LITTLE_ENDIAN
+	uint64_t v;
+	memcpy(&v, p, 8);
+	return v;
+#else
+	return (uint64_t)p[0] | ((uint64_t)p[1] << 8) | ((uint64_t)p[2] << 16) | ((uint64_t)p[3] << 24) |
+		((uint64_t)p[4] << 32) | ((uint64_t)p[5] << 40) | ((uint64_t)p[6] << 48) | ((uint64_t)p[7] << 56);
+#endif
+}
+
+static inline uint32_t readLE32(const unsigned char* p) {
+#ifdef XXH_LITTLE_ENDIAN
+	uint32_t v;
+	memcpy(&v, p, 4);
+	return v;
+#else
+	return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+#endif
+}
+
+static inline uint64_t xxhRound(uint64_t acc, uint64_t input) {
+	acc += input * PRIME64_2;
+	acc = ROTL64(acc, 31);
+	return acc * PRIME64_1;
+}
+
+static inline uint64_t xxhMergeRound(uint64_t acc, uint64_t val) {
+	acc ^= xxhRound(0, val);
+	return acc * PRIME64_1 + PRIME64_4;
+}
+
+/* consume 32 bytes stripes, returns pointer after last consumed stripe */
+static inline const unsigned char* xxhStripes(uint64_t v[4], const unsigned char* p, const unsigned char* limit) {
+	uint64_t v1 = v[0], v2 = v[1], v3 = v[2], v4 = v[3];
+	do {
+		v1 = xxhRound(v1, readLE64(p));
+		v2 = xxhRound(v2, readLE64(p + 8));
+		v3 = xxhRound(v3, readLE64(p + 16));
+		v4 = xxhRound(v4, readLE64(p + 24));
+		p += 32;
+	} while(p <= limit);
+	v[0] = v1;
+	v[1] = v2;
+	v[2] = v3;
+	v[3] = v4;
+	return p;
+}
+
+static inline uint64_t xxhConverge(const uint64_t v[4]) {
+	uint64_t h = ROTL64(v[0], 1) + ROTL64(v[1], 7) + ROTL64(v[2], 12) + ROTL64(v[3], 18);
+	h = xxhMergeRound(h, v[0]);
+	h = xxhMergeRound(h, v[1]);
+	h = xxhMergeRound(h, v[2]);
+	h = xxhMergeRound(h, v[3]);
+	return h;
+}
+
+/* mix remaining bytes (less than 32) and avalanche */
+static uint64_t xxhFinalize(uint64_t h, const unsigned char* p, size_t len) {
+	while(len >= 8) {
+		h ^= xxhRound(0, readLE64(p));
+		h = ROTL64(h, 27) * PRIME64_1 + PRIME64_4;
+		p += 8;
+		len -= 8;
+	}
+	if(len >= 4) {
+		h ^= (uint64_t)readLE32(p) * PRIME64_1;
+		h = ROTL64(h, 23) * PRIME64_2 + PRIME64_3;
+		p += 4;
+		len -= 4;
+	}
+	while(len > 0) {
+		h ^= (*p) * PRIME64_5;
+		h = ROTL64(h, 11) * PRIME64_1;
+		p++;
+		len--;
+	}
+	
+	// avalanche
+	h ^= h >> 33;
+	h *= PRIME64_2;
+	h ^= h >> 29;
+	h *= PRIME64_3;
+	h ^= h >> 32;
+	return h;
+}
+
+uint64_t CCXXHash::hash64(const void* data, size_t len, uint64_t seed) {
+	const unsigned char* p = (const unsigned char*)data;
+	uint64_t h;
+	size_t remain = len;
+	if(len >= 32) {
+		uint64_t v[4] = {
+			seed + PRIME64_1 + PRIME64_2,
+			seed + PRIME64_2,
+			seed,
+			seed - PRIME64_1
+		};
+		const unsigned char* end = p + len;
+		p = xxhStripes(v, p, end - 32);
+		remain = end - p;
+		h = xxhConverge(v);
+	} else {
+		h = seed + PRIME64_5;
+	}
+	h += (uint64_t)len;
+	return xxhFinalize(h, p, remain);
+}
+
+uint64_t CCXXHash::hash64String(const char* s, uint64_t seed) {
+	return hash64(s, strlen(s), seed);
+}
+
+uint64_t CCXXHash::hash64String(const string& s, uint64_t seed) {
+	return hash64(s.data(), s.length(), seed);
+}
+
+void CCXXHash::init(ccXXH64Context* context, uint64_t seed) {
+	memset(context, 0, sizeof(ccXXH64Context));
+	context->seed = seed;
+	context->v[0] = seed + PRIME64_1 + PRIME64_2;
+	context->v[1] = seed + PRIME64_2;
+	context->v[2] = seed;
+	context->v[3] = seed - PRIME64_1;
+}
+
+void CCXXHash::update(ccXXH64Context* context, const void* data, size_t len) {
+	const unsigned char* p = (const unsigned char*)data;
+	const unsigned char* end = p + len;
+	context->totalLen += len;
+	
+	// not enough for a stripe, just buffer it
+	if(context->memSize + len < 32) {
+		memcpy(context->mem + context->memSize, p, len);
+		context->memSize += (uint32_t)len;
+		return;
+	}
+	
+	// complete buffered stripe
+	if(context->memSize > 0) {
+		size_t fill = 32 - context->memSize;
+		memcpy(context->mem + context->memSize, p, fill);
+		xxhStripes(context->v, context->mem, context->mem);
+		p += fill;
+		context->memSize = 0;
+	}
+	
+	// stripes in input
+	if(p + 32 <= end) {
+		p = xxhStripes(context->v, p, end - 32);
+	}
+	
+	// buffer the rest
+	if(p < end) {
+		memcpy(context->mem, p, end - p);
+		context->memSize = (uint32_t)(end - p);
+	}
+}
+
+uint64_t CCXXHash::final(const ccXXH64Context* context) {
+	uint64_t h;
+	if(context->totalLen >= 32) {
+		h = xxhConverge(context->v);
+	} else {
+		h = context->seed + PRIME64_5;
+	}
+	h += context->totalLen;
+	return xxhFinalize(h, context->mem, context->memSize);
+}
+
+void CCXXHash::toHex(uint64_t h, char hex[17]) {
+	for(int i = 15; i >= 0; i--) {
+		hex[i] = HEX_DIGITS[h & 0x0f];
+		h >>= 4;
+	}
+	hex[16] = 0;
+}
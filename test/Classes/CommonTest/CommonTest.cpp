@@ -4,14 +4,19 @@
 
 TESTLAYER_CREATE_FUNC(CommonCalendar);
 TESTLAYER_CREATE_FUNC(CommonGradientSprite);
+TESTLAYER_CREATE_FUNC(CommonHSVBatch);
 TESTLAYER_CREATE_FUNC(CommonLocale);
 TESTLAYER_CREATE_FUNC(CommonLocalization);
+TESTLAYER_CREATE_FUNC(CommonMD5Batch);
 TESTLAYER_CREATE_FUNC(CommonMenuItemColor);
 TESTLAYER_CREATE_FUNC(CommonMissile);
+TESTLAYER_CREATE_FUNC(CommonParseDouble);
+TESTLAYER_CREATE_FUNC(CommonPerformance);
 TESTLAYER_CREATE_FUNC(CommonRichLabel);
 TESTLAYER_CREATE_FUNC(CommonResourceLoader);
 TESTLAYER_CREATE_FUNC(CommonShake);
 TESTLAYER_CREATE_FUNC(CommonScrollView);
+TESTLAYER_CREATE_FUNC(CommonStringsParser);
 TESTLAYER_CREATE_FUNC(CommonTiledSprite);
 TESTLAYER_CREATE_FUNC(CommonToast);
 TESTLAYER_CREATE_FUNC(CommonTreeFadeInOut);
@@ -19,14 +24,19 @@ TESTLAYER_CREATE_FUNC(CommonTreeFadeInOut);
 static NEWTESTFUNC createFunctions[] = {
     CF(CommonCalendar),
 	CF(CommonGradientSprite),
+    CF(CommonHSVBatch),
 	CF(CommonLocale),
     CF(CommonLocalization),
+    CF(CommonMD5Batch),
     CF(CommonMenuItemColor),
     CF(CommonMissile),
+    CF(CommonParseDouble),
+    CF(CommonPerformance),
 	CF(CommonRichLabel),
 	CF(CommonResourceLoader),
     CF(CommonShake),
 	CF(CommonScrollView),
+    CF(CommonStringsParser),
     CF(CommonTiledSprite),
     CF(CommonToast),
 	CF(CommonTreeFadeInOut),
@@ -229,6 +239,70 @@ std::string CommonGradientSprite::subtitle()
     return "Gradient Sprite";
 }
 
+//------------------------------------------------------------------
+//
+// HSV Batch
+//
+//------------------------------------------------------------------
+void CommonHSVBatch::onEnter()
+{
+    CommonDemo::onEnter();
+    
+    CCSize visibleSize = CCDirector::sharedDirector()->getVisibleSize();
+	CCPoint origin = CCDirector::sharedDirector()->getVisibleOrigin();
+    
+    // every rgb color, converted in chunks whose size is not a multiple of four
+    // so that tails are used too
+    const size_t chunk = 4099;
+    vector<ccColor3B> rgb(chunk);
+    vector<ccColorHSV> hsv(chunk);
+    vector<ccColor3B> back(chunk);
+    vector<ccColor4B> adjusted(chunk);
+    int checked = 0;
+    int failed = 0;
+    for(unsigned int start = 0; start < 0x1000000; start += chunk) {
+        size_t n = MIN(chunk, 0x1000000 - start);
+        for(size_t i = 0; i < n; i++) {
+            unsigned int c = start + i;
+            rgb[i] = ccc3(c >> 16, (c >> 8) & 0xff, c & 0xff);
+            adjusted[i] = ccc4(rgb[i].r, rgb[i].g, rgb[i].b, c & 0xff);
+        }
+        
+        // batch versions
+        CCUtils::ccc32hsv(&rgb[0], &hsv[0], n);
+        CCUtils::hsv2ccc3(&hsv[0], &back[0], n);
+        CCUtils::adjustHSV(&adjusted[0], n, 97.5f, -0.125f, 0.2f);
+        
+        // compare with scalar versions bit by bit
+        for(size_t i = 0; i < n; i++) {
+            ccColorHSV h = CCUtils::ccc32hsv(rgb[i]);
+            ccColor3B b = CCUtils::hsv2ccc3(hsv[i]);
+            ccColor4B a = ccc4(rgb[i].r, rgb[i].g, rgb[i].b, (start + i) & 0xff);
+            CCUtils::adjustHSV(&a, 1, 97.5f, -0.125f, 0.2f);
+            checked++;
+            if(memcmp(&h, &hsv[i], sizeof(h)) || memcmp(&b, &back[i], sizeof(b)) || memcmp(&a, &adjusted[i], sizeof(a))) {
+                if(failed < 10) {
+                    CCLOGERROR("hsv batch mismatch: color %06x, hsv (%.9g, %.9g, %.9g) != (%.9g, %.9g, %.9g)",
+                               start + (unsigned int)i, hsv[i].h, hsv[i].s, hsv[i].v, h.h, h.s, h.v);
+                }
+                failed++;
+            }
+        }
+    }
+    
+    char buf[128];
+    sprintf(buf, "%s\n%d checked, %d failed", failed ? "FAILED" : "PASSED", checked, failed);
+    CCLabelTTF* label = CCLabelTTF::create(buf, "Helvetica", 16);
+    label->setPosition(ccp(origin.x + visibleSize.width / 2,
+                           origin.y + visibleSize.height / 2));
+    addChild(label);
+}
+
+std::string CommonHSVBatch::subtitle()
+{
+    return "HSV Batch vs Scalar";
+}
+
 //------------------------------------------------------------------
 //
 // Locale
@@ -289,6 +363,71 @@ std::string CommonLocalization::subtitle()
     return "Localization";
 }
 
+//------------------------------------------------------------------
+//
+// MD5 Batch
+//
+//------------------------------------------------------------------
+void CommonMD5Batch::onEnter()
+{
+    CommonDemo::onEnter();
+    
+    CCSize visibleSize = CCDirector::sharedDirector()->getVisibleSize();
+	CCPoint origin = CCDirector::sharedDirector()->getVisibleOrigin();
+    
+    // lengths around block and padding boundaries, unequal in every lane group
+    static const size_t lengths[] = {
+        0, 55, 56, 64, 1, 63, 65, 119, 120, 127, 128, 1000, 4095, 57, 0, 64, 3
+    };
+    const size_t count = sizeof(lengths) / sizeof(lengths[0]);
+    
+    // fill buffers with pseudo random bytes
+    vector<char*> buffers(count);
+    unsigned int seed = 12345;
+    for(size_t i = 0; i < count; i++) {
+        buffers[i] = (char*)malloc(lengths[i] + 1);
+        for(size_t j = 0; j < lengths[i]; j++) {
+            seed = seed * 1103515245 + 12345;
+            buffers[i][j] = (char)(seed >> 16);
+        }
+    }
+    
+    // hash every prefix count, so that every lane count and tail is used
+    int checked = 0;
+    int failed = 0;
+    unsigned char digests[sizeof(lengths) / sizeof(lengths[0])][16];
+    for(size_t n = 1; n <= count; n++) {
+        CCMD5::md5Batch((const void* const*)&buffers[0], lengths, n, digests);
+        for(size_t i = 0; i < n; i++) {
+            char batchHex[33];
+            char hex[33];
+            CCMD5::toHex(digests[i], batchHex);
+            CCMD5::md5(buffers[i], lengths[i], hex);
+            checked++;
+            if(strcmp(batchHex, hex)) {
+                failed++;
+                CCLOGERROR("md5Batch mismatch: count %d, buffer %d, length %d, %s != %s",
+                           (int)n, (int)i, (int)lengths[i], batchHex, hex);
+            }
+        }
+    }
+    for(size_t i = 0; i < count; i++) {
+        free(buffers[i]);
+    }
+    
+    char buf[128];
+    sprintf(buf, "%s\n%d checked, %d failed", failed ? "FAILED" : "PASSED", checked, failed);
+    CCLabelTTF* label = CCLabelTTF::create(buf, "Helvetica", 16);
+    label->setPosition(ccp(origin.x + visibleSize.width / 2,
+                           origin.y + visibleSize.height / 2));
+    addChild(label);
+}
+
+std::string CommonMD5Batch::subtitle()
+{
+    return "MD5 Batch vs Scalar";
+}
+
 //------------------------------------------------------------------
 //
 // Localization
@@ -375,6 +514,178 @@ std::string CommonMissile::subtitle()
     return "Missile";
 }
 
+//------------------------------------------------------------------
+//
+// Parse Double
+//
+//------------------------------------------------------------------
+void CommonParseDouble::onEnter()
+{
+    CommonDemo::onEnter();
+    
+    CCSize visibleSize = CCDirector::sharedDirector()->getVisibleSize();
+	CCPoint origin = CCDirector::sharedDirector()->getVisibleOrigin();
+    
+    // exact power limits, 2^53 neighbours, halfway cases, denormals and overflow
+    static const char* boundaries[] = {
+        "0", "-0", "1", "0.1", "0.3", "-2.5e-3", "  +7", "1e22", "1e23", "1e-22", "1e-23",
+        "9007199254740991", "9007199254740992", "9007199254740993", "9007199254740995",
+        "72057594037927933", "1234567890123456789", "12345678901234567890123",
+        "1.00000000000000011102230246251565404236316680908203124",
+        "1.00000000000000011102230246251565404236316680908203125",
+        "1.00000000000000011102230246251565404236316680908203126",
+        "2.2250738585072011e-308", "2.2250738585072014e-308",
+        "4.9406564584124654e-324", "2.4703282292062327e-324", "2.4703282292062328e-324",
+        "1.7976931348623157e308", "1.7976931348623158e308", "1.7976931348623159e308",
+        "3.4028235e38", "1.17549435e-38", "1.4e-45", "1e-400", "1e400", ".5", "5.", "1e", "1e+"
+    };
+    const int count = sizeof(boundaries) / sizeof(boundaries[0]);
+    
+    int checked = 0;
+    int failed = 0;
+    char buf[64];
+    unsigned int seed = 12345;
+    for(int i = 0; i < count + 100000; i++) {
+        // after boundaries, random 1 to 25 digits with random exponent
+        const char* s;
+        if(i < count) {
+            s = boundaries[i];
+        } else {
+            char* p = buf;
+            seed = seed * 1103515245 + 12345;
+            int digits = 1 + (seed >> 16) % 25;
+            for(int j = 0; j < digits; j++) {
+                seed = seed * 1103515245 + 12345;
+                *p++ = '0' + (seed >> 16) % 10;
+                if(j == 0)
+                    *p++ = '.';
+            }
+            seed = seed * 1103515245 + 12345;
+            sprintf(p, "e%d", (int)((seed >> 16) % 650) - 330);
+            s = buf;
+        }
+        
+        // compare bits so that sign of zero is checked too
+        double v = CCUtils::parseDouble(s, strlen(s));
+        double expected = strtod(s, NULL);
+        checked++;
+        if(memcmp(&v, &expected, sizeof(double))) {
+            failed++;
+            CCLOGERROR("parseDouble mismatch: %s, %.17g != %.17g", s, v, expected);
+        }
+    }
+    
+    sprintf(buf, "%s\n%d checked, %d failed", failed ? "FAILED" : "PASSED", checked, failed);
+    CCLabelTTF* label = CCLabelTTF::create(buf, "Helvetica", 16);
+    label->setPosition(ccp(origin.x + visibleSize.width / 2,
+                           origin.y + visibleSize.height / 2));
+    addChild(label);
+}
+
+std::string CommonParseDouble::subtitle()
+{
+    return "Parse Double vs strtod";
+}
+
+//------------------------------------------------------------------
+//
+// Performance
+//
+//------------------------------------------------------------------
+/// throughput in GB per second
+static double gbPerSecond(double bytes, int64_t ns) {
+    return ns > 0 ? bytes / ns : 0;
+}
+
+void CommonPerformance::onEnter()
+{
+    CommonDemo::onEnter();
+    
+    CCSize visibleSize = CCDirector::sharedDirector()->getVisibleSize();
+	CCPoint origin = CCDirector::sharedDirector()->getVisibleOrigin();
+    
+    // pseudo random data, bigger than cache
+    const size_t size = 32 * 1024 * 1024;
+    const int rounds = 4;
+    char* data = (char*)malloc(size);
+    unsigned int seed = 12345;
+    for(size_t i = 0; i < size; i++) {
+        seed = seed * 1103515245 + 12345;
+        data[i] = (char)(seed >> 16);
+    }
+    string result;
+    char line[128];
+    
+    // md5 core
+    char hex[33];
+    int64_t start = CCClock::nanoTime();
+    for(int i = 0; i < rounds; i++) {
+        CCMD5::md5(data, size, hex);
+    }
+    sprintf(line, "MD5: %.2f GB/s\n", gbPerSecond((double)size * rounds, CCClock::nanoTime() - start));
+    result += line;
+    
+    // xxhash, result is kept so that loop is not optimized out
+    uint64_t h = 0;
+    start = CCClock::nanoTime();
+    for(int i = 0; i < rounds; i++) {
+        h ^= CCXXHash::hash64(data, size, i);
+    }
+    sprintf(line, "XXHash64: %.2f GB/s (%08x)\n", gbPerSecond((double)size * rounds, CCClock::nanoTime() - start), (unsigned int)h);
+    result += line;
+    
+    free(data);
+    
+    // search in sorted tables, even keys so half of lookups miss, in ns per lookup
+    const size_t lookups = 1000000;
+    vector<int> keys(lookups);
+    vector<int> results(lookups);
+    static const size_t tableSizes[] = { 1000, 100000, 1000000, 10000000 };
+    for(size_t t = 0; t < sizeof(tableSizes) / sizeof(tableSizes[0]); t++) {
+        size_t n = tableSizes[t];
+        vector<int> table(n);
+        for(size_t i = 0; i < n; i++) {
+            table[i] = (int)i * 2;
+        }
+        for(size_t i = 0; i < lookups; i++) {
+            seed = seed * 1103515245 + 12345;
+            keys[i] = (int)(((seed >> 8) ^ (seed << 16)) % (n * 2));
+        }
+        CCSearchIndex index(&table[0], n);
+        
+        // sum of results is kept so that loops are not optimized out
+        int64_t sum = 0;
+        start = CCClock::nanoTime();
+        for(size_t i = 0; i < lookups; i++) {
+            sum += CCUtils::binarySearch(&table[0], n, keys[i]);
+        }
+        int64_t binaryTime = CCClock::nanoTime() - start;
+        start = CCClock::nanoTime();
+        for(size_t i = 0; i < lookups; i++) {
+            sum -= index.search(keys[i]);
+        }
+        int64_t indexTime = CCClock::nanoTime() - start;
+        start = CCClock::nanoTime();
+        index.search(&keys[0], lookups, &results[0]);
+        int64_t batchTime = CCClock::nanoTime() - start;
+        sprintf(line, "Search %d keys: binary %.0fns, index %.0fns, batch %.0fns%s\n", (int)n,
+                (double)binaryTime / lookups, (double)indexTime / lookups, (double)batchTime / lookups,
+                sum ? " MISMATCH" : "");
+        result += line;
+    }
+    
+    CCLOG("%s", result.c_str());
+    CCLabelTTF* label = CCLabelTTF::create(result.c_str(), "Helvetica", 16);
+    label->setPosition(ccp(origin.x + visibleSize.width / 2,
+                           origin.y + visibleSize.height / 2));
+    addChild(label);
+}
+
+std::string CommonPerformance::subtitle()
+{
+    return "Performance, build in release mode";
+}
+
 //------------------------------------------------------------------
 //
 // Rich Label
@@ -580,6 +891,78 @@ std::string CommonScrollView::subtitle()
     return "Scroll View (Support Fling)";
 }
 
+//------------------------------------------------------------------
+//
+// Strings Parser
+//
+//------------------------------------------------------------------
+void CommonStringsParser::onEnter()
+{
+    CommonDemo::onEnter();
+    
+    CCSize visibleSize = CCDirector::sharedDirector()->getVisibleSize();
+	CCPoint origin = CCDirector::sharedDirector()->getVisibleOrigin();
+    
+    // malformed tags must be skipped without hanging, and following strings still parsed
+    static const char* xml =
+        "<resources>"
+        "<string name=\"a\" / >A</string>"
+        "<string / >X</string>"
+        "<string name=\"b\"/ x>B</string>"
+        "<string =\"q\" name=\"c\">C</string>"
+        "<string name=\"d\" = >D</string>"
+        "<string name=\"e\">E</string>"
+        "<string name=\"f\">\\u00e9\\uD83D\\uDE00</string>"
+        "<string name=\"g\">\\uD83Dx\\uDE00</string>"
+        "</resources>";
+    
+    // surrogate pair is decoded to one code point, lone surrogate is replaced with U+FFFD
+    static const char* expected[] = {
+        "a", "A", "b", "B", "c", "C", "d", "D", "e", "E",
+        "f", "\xc3\xa9\xf0\x9f\x98\x80",
+        "g", "\xef\xbf\xbdx\xef\xbf\xbd"
+    };
+    const int count = sizeof(expected) / sizeof(expected[0]);
+    string xmlPath = CCFileUtils::sharedFileUtils()->getWritablePath() + "malformed_strings.xml";
+    string binPath = CCFileUtils::sharedFileUtils()->getWritablePath() + "malformed_strings.bin";
+    FILE* fp = fopen(xmlPath.c_str(), "wb");
+    if(fp) {
+        fwrite(xml, 1, strlen(xml), fp);
+        fclose(fp);
+    }
+    
+    // compile and check every string
+    int failed = 0;
+    CCStringTable t;
+    if(!CCLocalization::compileAndroidStrings(xmlPath, binPath) || !t.loadFile(binPath)) {
+        failed = -1;
+    } else {
+        for(int i = 0; i < count; i += 2) {
+            size_t len;
+            const char* v = t.lookup(expected[i], strlen(expected[i]), &len);
+            if(!v || len != strlen(expected[i + 1]) || memcmp(v, expected[i + 1], len)) {
+                failed++;
+                CCLOGERROR("strings parser: key %s is not parsed correctly", expected[i]);
+            }
+        }
+    }
+    
+    char buf[128];
+    if(failed < 0)
+        sprintf(buf, "FAILED\ncan't compile strings");
+    else
+        sprintf(buf, "%s\n%d strings, %d failed", failed ? "FAILED" : "PASSED", (int)t.size(), failed);
+    CCLabelTTF* label = CCLabelTTF::create(buf, "Helvetica", 16);
+    label->setPosition(ccp(origin.x + visibleSize.width / 2,
+                           origin.y + visibleSize.height / 2));
+    addChild(label);
+}
+
+std::string CommonStringsParser::subtitle()
+{
+    return "Malformed and Escaped Strings XML";
+}
+
 //------------------------------------------------------------------
 //
 // Tiled Sprite
@@ -44,6 +44,13 @@ public:
     virtual string subtitle();
 };
 
+class CommonHSVBatch : public CommonDemo
+{
+public:
+    virtual void onEnter();
+    virtual string subtitle();
+};
+
 class CommonLocale : public CommonDemo
 {
 public:
@@ -58,6 +65,13 @@ public:
     virtual string subtitle();
 };
 
+class CommonMD5Batch : public CommonDemo
+{
+public:
+    virtual void onEnter();
+    virtual string subtitle();
+};
+
 class CommonMenuItemColor : public CommonDemo
 {
 public:
@@ -74,6 +88,20 @@ public:
     void onHit();
 };
 
+class CommonParseDouble : public CommonDemo
+{
+public:
+    virtual void onEnter();
+    virtual string subtitle();
+};
+
+class CommonPerformance : public CommonDemo
+{
+public:
+    virtual void onEnter();
+    virtual string subtitle();
+};
+
 class CommonRichLabel : public CommonDemo
 {
 public:
@@ -113,6 +141,13 @@ public:
 	CCLayer* createScrollContent(const CCSize& size);
 };
 
+class CommonStringsParser : public CommonDemo
+{
+public:
+    virtual void onEnter();
+    virtual string subtitle();
+};
+
 class CommonTiledSprite : public CommonDemo
 {
 public: